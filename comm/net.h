@@ -72,6 +72,7 @@ typedef struct net_ch {
         u16            dst_port, src_port;
         sockfd_t       fd;
         net_async_cb_f f_send_cb, f_recv_cb;
+        void          *arg; // 回调参数, 由调用者使用
 } net_ch_t;
 
 typedef struct {
@@ -80,6 +81,9 @@ typedef struct {
         usz            size;
         net_async_cb_f f_cb;
         ATOMIC(bool) processed;
+#ifdef __linux__
+        u8 cqe_num; // 尚未收到的 CQE 数量, 带超时的接收为 2, 全部收到后释放
+#endif
 #ifdef _WIN32
         OVERLAPPED ov;
 #endif
@@ -120,6 +124,9 @@ HAPI isz net_sync_recv_spin(const net_ch_t *ch, void *rx_buf, usz cap, u32 timeo
 HAPI isz net_async_send(net_t *net, net_ch_t *ch, void *tx_buf, usz size);
 HAPI isz net_async_recv(net_t *net, net_ch_t *ch, void *rx_buf, usz cap, u32 timeout_us);
 HAPI int net_poll(net_t *net);
+#ifdef __linux__
+HAPI void net_cqe_dispatch(net_t *net, const struct io_uring_cqe *cqe);
+#endif
 
 HAPI isz net_send(net_t *net, net_ch_t *ch, void *tx_buf, usz size);
 HAPI isz net_recv(net_t *net, net_ch_t *ch, void *rx_buf, usz cap, u32 timeout_us);
@@ -317,10 +324,11 @@ net_async_send(net_t *net, net_ch_t *ch, void *tx_buf, usz size)
         if (!req)
                 return -MEALLOC;
 
-        req->ch   = ch;
-        req->buf  = tx_buf;
-        req->size = size;
-        req->f_cb = ch->f_send_cb;
+        req->ch      = ch;
+        req->buf     = tx_buf;
+        req->size    = size;
+        req->f_cb    = ch->f_send_cb;
+        req->cqe_num = 1;
 
         io_uring_prep_send(send_sqe, ch->fd, tx_buf, size, 0);
         io_uring_sqe_set_data(send_sqe, req);
@@ -363,10 +371,11 @@ net_async_recv(net_t *net, net_ch_t *ch, void *rx_buf, usz cap, u32 timeout_us)
         if (!req)
                 return -MEALLOC;
 
-        req->ch   = ch;
-        req->buf  = rx_buf;
-        req->size = cap;
-        req->f_cb = ch->f_recv_cb;
+        req->ch      = ch;
+        req->buf     = rx_buf;
+        req->size    = cap;
+        req->f_cb    = ch->f_recv_cb;
+        req->cqe_num = 2;
 
         struct io_uring_sqe *recv_sqe = io_uring_get_sqe(&lo->ring);
         if (!recv_sqe)
@@ -412,6 +421,24 @@ net_async_recv(net_t *net, net_ch_t *ch, void *rx_buf, usz cap, u32 timeout_us)
 #endif
 }
 
+#ifdef __linux__
+/* 处理一个 CQE: 接收与其链接的超时各产生一个 CQE, 回调只在第一个 CQE 执行, 最后一个 CQE 到达后才释放请求 */
+HAPI void
+net_cqe_dispatch(net_t *net, const struct io_uring_cqe *cqe)
+{
+        DECL_PTRS(net, cfg);
+
+        net_async_req_t *req = (net_async_req_t *)io_uring_cqe_get_data(cqe);
+        if (!req)
+                return;
+
+        if (ATOMIC_EXCHANGE(&req->processed, 1) == 0)
+                req->f_cb(req->ch, req->buf, cqe->res);
+        if (--req->cqe_num == 0)
+                mp_free(cfg->mp, req);
+}
+#endif
+
 HAPI int
 net_poll(net_t *net)
 {
@@ -420,17 +447,7 @@ net_poll(net_t *net)
 #ifdef __linux__
         struct io_uring_cqe *cqe;
         while (io_uring_peek_cqe(&lo->ring, &cqe) == 0) {
-                net_async_req_t *req = (net_async_req_t *)io_uring_cqe_get_data(cqe);
-                if (!req) {
-                        io_uring_cqe_seen(&lo->ring, cqe);
-                        continue;
-                }
-
-                if (ATOMIC_EXCHANGE(&req->processed, 1) == 0) {
-                        req->f_cb(req->ch, req->buf, cqe->res);
-                        mp_free(cfg->mp, req);
-                }
-
+                net_cqe_dispatch(net, cqe);
                 io_uring_cqe_seen(&lo->ring, cqe);
         }
         return 0;
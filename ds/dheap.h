@@ -0,0 +1,234 @@
+#ifndef DHEAP_H
+#define DHEAP_H
+
+#include "../util/macrodef.h"
+#include "../util/mathdef.h"
+#include "../util/typedef.h"
+
+/*
+ * 侵入式 4 叉最小堆.
+ * 堆数组存放 (key, node) 对, 键内联且 4 个兄弟节点连续存放, 树高减半, 下沉时比较无需解引用节点;
+ * 节点记录自身下标, 支持 O(log n) 删除与改键. 存储由调用者提供, 不做动态分配.
+ */
+#define DHEAP_ARITY    (4)
+#define DHEAP_IDX_NONE ((usz)-1)
+
+typedef struct {
+        usz idx; // 在堆数组中的下标, DHEAP_IDX_NONE 表示不在堆中
+} dheap_node_t;
+
+typedef struct {
+        u64           key;
+        dheap_node_t *node;
+} dheap_entry_t;
+
+typedef struct {
+        dheap_entry_t *entries; // 堆数组
+        usz            cap;     // 容量
+        usz            size;    // 元素个数
+} dheap_t;
+
+/* -------------------------------------------------------------------------- */
+/*                                   声明                                     */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief 初始化堆
+ *
+ * @param heap
+ * @param entries 堆数组, 建议按缓存行对齐
+ * @param cap 容量
+ */
+HAPI void dheap_init(dheap_t *heap, dheap_entry_t *entries, usz cap);
+
+/**
+ * @brief 初始化节点, 使其处于不在堆中的状态
+ *
+ * @param node
+ */
+HAPI void dheap_node_init(dheap_node_t *node);
+
+/**
+ * @brief 节点是否在堆中
+ *
+ * @param heap
+ * @param node
+ * @return true
+ * @return false
+ */
+HAPI bool dheap_contains(const dheap_t *heap, const dheap_node_t *node);
+
+/**
+ * @brief 插入节点
+ *
+ * @param heap
+ * @param node
+ * @param key
+ * @return 0 成功, -1 堆已满
+ */
+HAPI int dheap_push(dheap_t *heap, dheap_node_t *node, u64 key);
+
+/**
+ * @brief 取键最小的节点, 不出堆
+ *
+ * @param heap
+ * @return 堆为空时返回 NULL
+ */
+HAPI dheap_node_t *dheap_top(const dheap_t *heap);
+
+/**
+ * @brief 弹出键最小的节点
+ *
+ * @param heap
+ * @return 堆为空时返回 NULL
+ */
+HAPI dheap_node_t *dheap_pop(dheap_t *heap);
+
+/**
+ * @brief 删除节点, 节点不在堆中时无操作
+ *
+ * @param heap
+ * @param node
+ */
+HAPI void dheap_del(dheap_t *heap, dheap_node_t *node);
+
+/**
+ * @brief 修改节点的键
+ *
+ * @param heap
+ * @param node 必须在堆中
+ * @param key
+ */
+HAPI void dheap_update(dheap_t *heap, dheap_node_t *node, u64 key);
+
+/* -------------------------------------------------------------------------- */
+/*                                   定义                                     */
+/* -------------------------------------------------------------------------- */
+
+HAPI void
+dheap_init(dheap_t *heap, dheap_entry_t *entries, const usz cap)
+{
+        heap->entries = entries;
+        heap->cap     = cap;
+        heap->size    = 0;
+}
+
+HAPI void
+dheap_node_init(dheap_node_t *node)
+{
+        node->idx = DHEAP_IDX_NONE;
+}
+
+HAPI bool
+dheap_contains(const dheap_t *heap, const dheap_node_t *node)
+{
+        return node->idx < heap->size && heap->entries[node->idx].node == node;
+}
+
+HAPI void
+dheap_place(dheap_t *heap, const usz idx, const dheap_entry_t entry)
+{
+        heap->entries[idx] = entry;
+        entry.node->idx    = idx;
+}
+
+HAPI void
+dheap_sift_up(dheap_t *heap, usz idx)
+{
+        const dheap_entry_t entry = heap->entries[idx];
+        while (idx > 0) {
+                const usz parent = (idx - 1) / DHEAP_ARITY;
+                if (heap->entries[parent].key <= entry.key)
+                        break;
+                dheap_place(heap, idx, heap->entries[parent]);
+                idx = parent;
+        }
+        dheap_place(heap, idx, entry);
+}
+
+HAPI void
+dheap_sift_down(dheap_t *heap, usz idx)
+{
+        const dheap_entry_t entry = heap->entries[idx];
+        for (;;) {
+                const usz first = idx * DHEAP_ARITY + 1;
+                if (first >= heap->size)
+                        break;
+
+                const usz last = MIN(first + DHEAP_ARITY, heap->size);
+                usz       min  = first;
+                for (usz i = first + 1; i < last; i++) {
+                        if (heap->entries[i].key < heap->entries[min].key)
+                                min = i;
+                }
+                if (entry.key <= heap->entries[min].key)
+                        break;
+
+                dheap_place(heap, idx, heap->entries[min]);
+                idx = min;
+        }
+        dheap_place(heap, idx, entry);
+}
+
+HAPI int
+dheap_push(dheap_t *heap, dheap_node_t *node, const u64 key)
+{
+        if (heap->size >= heap->cap)
+                return -1;
+
+        const usz idx      = heap->size++;
+        heap->entries[idx] = (dheap_entry_t){.key = key, .node = node};
+        dheap_sift_up(heap, idx);
+        return 0;
+}
+
+HAPI dheap_node_t *
+dheap_top(const dheap_t *heap)
+{
+        return heap->size ? heap->entries[0].node : NULL;
+}
+
+HAPI dheap_node_t *
+dheap_pop(dheap_t *heap)
+{
+        dheap_node_t *node = dheap_top(heap);
+        if (node)
+                dheap_del(heap, node);
+        return node;
+}
+
+HAPI void
+dheap_del(dheap_t *heap, dheap_node_t *node)
+{
+        if (!dheap_contains(heap, node))
+                return;
+
+        const usz idx  = node->idx;
+        const usz last = --heap->size;
+        node->idx      = DHEAP_IDX_NONE;
+        if (idx == last)
+                return;
+
+        // 用末尾元素填补空位, 再按新键向上或向下调整
+        const u64 key = heap->entries[idx].key;
+        dheap_place(heap, idx, heap->entries[last]);
+        if (heap->entries[idx].key < key)
+                dheap_sift_up(heap, idx);
+        else
+                dheap_sift_down(heap, idx);
+}
+
+HAPI void
+dheap_update(dheap_t *heap, dheap_node_t *node, const u64 key)
+{
+        const usz idx  = node->idx;
+        const u64 prev = heap->entries[idx].key;
+
+        heap->entries[idx].key = key;
+        if (key < prev)
+                dheap_sift_up(heap, idx);
+        else
+                dheap_sift_down(heap, idx);
+}
+
+#endif // !DHEAP_H
@@ -1,10 +1,14 @@
 #ifndef DS_H
 #define DS_H
 
+#include "dheap.h"
 #include "list.h"
 #include "mp.h"
+#include "mpmc.h"
 #include "mpsc.h"
 #include "rbtree.h"
 #include "spsc.h"
+#include "twheel.h"
+#include "wsdeque.h"
 
 #endif // !DS_H
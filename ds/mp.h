@@ -1,40 +1,215 @@
 #ifndef MP_H
 #define MP_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #include "../ds/list.h"
+#include "../util/bitops.h"
 #include "../util/macrodef.h"
+#include "../util/mathdef.h"
+#include "../util/timeops.h"
 #include "../util/typedef.h"
 
-#define MP_SIZE              (64 * 1024)
+#define MP_SIZE              (64 * 1024) // MP_INLINE_BUF 内嵌缓冲区大小
 #define MP_ALIGN             (8)
 #define MP_ALIGN_UP(sz)      (((sz) + (MP_ALIGN - 1)) & ~(MP_ALIGN - 1))
 #define MP_BLOCK_HEADER_SIZE MP_ALIGN_UP(sizeof(mp_blk_t))
 
+/*
+ * 每个已分配块紧邻用户指针之前的 usz 为块标签: 块大小 (包含头部), 低 3 位为标志位.
+ * mp_free 据此区分块来源, 因此 slab 模式下超出最大尺寸级别的申请可以退回首次适配.
+ */
+#define MP_TAG_SIZE          (sizeof(usz))
+#define MP_TAG_SLAB          (1) // slab 块
+#define MP_TAG_FREE          (2) // tlsf 空闲块
+#define MP_TAG_MASK          (MP_ALIGN - 1)
+#define MP_BLK_TAG(ptr)      (((usz *)(ptr))[-1])
+
+#define MP_SLAB_SHIFT_MIN    (4)  // 最小 slab 块 16B (包含标签)
+#define MP_SLAB_SHIFT_MAX    (11) // 最大 slab 块 2KB (包含标签)
+#define MP_SLAB_CLASS_NUM    (MP_SLAB_SHIFT_MAX - MP_SLAB_SHIFT_MIN + 1)
+#define MP_FF_BIN_NUM        (64) // 首次适配空闲块按 floor(log2(size)) 分级计数
+
+/*
+ * 定义 MP_INLINE_BUF 后, mp_t 内嵌 MP_SIZE 字节缓冲区, 可以 mp_init / mp_init_policy 初始化.
+ * 未定义时 mp_t 只记录调用方提供的缓冲区 (base/cap), 以 mp_init_ext 初始化, 不占用内嵌存储.
+ * 使用同一个 mp_t 的编译单元必须使用相同的定义.
+ */
+
+/*
+ * 定义 MP_MAGAZINE 后, slab 块在每个线程内有一层按尺寸级别的缓存 (magazine).
+ * 只有 magazine 取空或放满时才持锁与全局池批量交换 MP_MAG_SIZE / 2 块.
+ * 线程退出前调用 mp_mag_flush_all 归还缓存块.
+ */
+#ifndef MP_MAG_SIZE
+#define MP_MAG_SIZE (32) // 每个尺寸级别缓存块数上限
+#endif
+#define MP_MAG_TLS_MAX     (4) // 每个线程可缓存的内存池数量
+
+/*
+ * TLSF: 一级按 2^fl 划分, 二级将 [2^fl, 2^(fl+1)) 等分为 MP_TLSF_SL_COUNT 段,
+ * 小于 MP_TLSF_SMALL 的块线性映射到 fl = 0. 两级位图定位空闲链表, 分配释放 O(1),
+ * 释放时立即与物理相邻的空闲块合并.
+ */
+#define MP_TLSF_SL_LOG2    (4)
+#define MP_TLSF_SL_COUNT   (1 << MP_TLSF_SL_LOG2)
+#define MP_TLSF_ALIGN_LOG2 (3) // log2(MP_ALIGN)
+#define MP_TLSF_FL_SHIFT   (MP_TLSF_SL_LOG2 + MP_TLSF_ALIGN_LOG2)
+#define MP_TLSF_FL_MAX     (32) // 块大小上限 2^32
+#define MP_TLSF_FL_COUNT   (MP_TLSF_FL_MAX - MP_TLSF_FL_SHIFT + 1)
+#define MP_TLSF_SMALL      ((usz)1 << MP_TLSF_FL_SHIFT)
+#define MP_TLSF_HDR_SIZE   offsetof(mp_tlsf_blk_t, next_free)
+#define MP_TLSF_BLK_MIN    sizeof(mp_tlsf_blk_t)
+
+/* mp_map 选项 */
+#define MP_MAP_HUGETLB     (1U << 0) // 优先使用大页, 未预留大页时退回普通页 + 透明大页
+#define MP_MAP_POPULATE    (1U << 1) // 映射时预先缺页
+#define MP_MAP_LOCK        (1U << 2) // mlock 锁定, 禁止换出
+#define MP_HUGEPAGE_SIZE   (2 * 1024 * 1024)
+
+/*
+ * 定义 MP_STATS 后统计内存池使用情况, 通过 mp_stats_snapshot 读取.
+ * 耗时直方图第 i 格统计 [2^i, 2^(i+1)) ns, 最后一格包含更长的耗时.
+ */
+#define MP_HIST_NUM        (16)
+
+#ifdef MP_STATS
+#define MP_STAT_ADD(mp, field, n) ATOMIC_FETCH_ADD_EXPLICIT(&(mp)->stats.field, (n), memory_order_relaxed)
+#define MP_STAT_SUB(mp, field, n) ATOMIC_FETCH_SUB_EXPLICIT(&(mp)->stats.field, (n), memory_order_relaxed)
+#else
+#define MP_STAT_ADD(mp, field, n)
+#define MP_STAT_SUB(mp, field, n)
+#endif
+
+/* 分配策略 */
+typedef enum {
+        MP_POLICY_FIRST_FIT, // 首次适配, 空闲块按地址排序
+        MP_POLICY_SLAB,      // 2^n 尺寸级别, 每级一个空闲栈, O(1) 分配释放
+        MP_POLICY_TLSF,      // 两级分离适配, O(1) 分配释放, 相邻空闲块合并
+} mp_policy_e;
+
 typedef struct {
         list_head_t blk_node; // 链表节点
         usz         size;     // 块大小 (包含头部)
 } mp_blk_t;
 
+typedef struct mp_slab_node {
+        struct mp_slab_node *next; // 空闲栈下一块 (存放在用户数据区)
+} mp_slab_node_t;
+
+typedef struct mp_tlsf_blk {
+        struct mp_tlsf_blk *prev_phys; // 物理前一块, 首块为 NULL
+        usz                 size;      // 块大小 (包含头部) | 标志位, 即块标签
+        struct mp_tlsf_blk *next_free; // 空闲链表 (仅空闲块有效, 位于用户数据区)
+        struct mp_tlsf_blk *prev_free;
+} mp_tlsf_blk_t;
+
+/* 统计快照, 纯数据结构, 可直接写入 shm 发布 */
+typedef struct {
+        usz live_bytes;                // 已分配字节 (包含块头)
+        usz peak_bytes;                // live_bytes 历史最大值
+        usz free_blocks;               // 空闲链表中的块数 (不含线性区域与线程缓存)
+        usz largest_free;              // 最大空闲块的下界 (包含块头), 含线性区域剩余, 见 mp_largest_free
+        u64 alloc_cnt;                 // 成功分配次数
+        u64 free_cnt;                  // 释放次数
+        u64 fail_cnt;                  // 分配失败次数
+        u64 alloc_hist[MP_HIST_NUM];   // 分配耗时直方图
+        u64 free_hist[MP_HIST_NUM];    // 释放耗时直方图
+} mp_stats_t;
+
+#ifdef MP_STATS
+typedef struct {
+        ATOMIC(usz) live_bytes;
+        ATOMIC(usz) peak_bytes;
+        ATOMIC(usz) free_blocks;
+        ATOMIC(u64) alloc_cnt;
+        ATOMIC(u64) free_cnt;
+        ATOMIC(u64) fail_cnt;
+        ATOMIC(u64) alloc_hist[MP_HIST_NUM];
+        ATOMIC(u64) free_hist[MP_HIST_NUM];
+} mp_counter_t;
+#endif
+
 typedef struct {
-        list_head_t blk_root;     // 空闲块链表头
-        u8          buf[MP_SIZE]; // 内存池缓冲区
-        usz         off;          // 当前已分配偏移
+        mp_policy_e     e_policy;                                      // 分配策略
+        list_head_t     blk_root;                                      // 空闲块链表头
+        u64             ff_map;                                        // 首次适配空闲块分级的非空位图
+        u32             ff_num[MP_FF_BIN_NUM];                         // 首次适配各级空闲块数
+        mp_slab_node_t *slab_root[MP_SLAB_CLASS_NUM];                  // 各尺寸级别空闲栈
+        u32             tlsf_fl_map;                                   // tlsf 一级位图
+        u32             tlsf_sl_map[MP_TLSF_FL_COUNT];                 // tlsf 二级位图
+        mp_tlsf_blk_t  *tlsf_root[MP_TLSF_FL_COUNT][MP_TLSF_SL_COUNT]; // tlsf 空闲链表
+        u8             *base;                                          // 内存池缓冲区, 内嵌缓冲区或调用方提供
+        usz             cap;                                           // 缓冲区大小
+        usz             off;                                           // 当前已分配偏移
+        usz             gen;                                           // mp_reset 次数, 用于作废线程缓存
         ATOMIC(u32) lock;
+#ifdef MP_STATS
+        mp_counter_t stats; // 统计计数
+#endif
+#ifdef MP_INLINE_BUF
+        u8 buf[MP_SIZE]; // 内嵌缓冲区
+#endif
 } mp_t;
 
+typedef struct {
+        u32   cnt;               // 缓存块数
+        void *blks[MP_MAG_SIZE]; // 缓存块 (用户指针), 栈结构
+} mp_mag_t;
+
+typedef struct {
+        mp_t    *mp;                       // 所属内存池, NULL 表示空闲
+        usz      gen;                      // 缓存建立时的 mp->gen
+        mp_mag_t mags[MP_SLAB_CLASS_NUM]; // 各尺寸级别缓存
+} mp_mag_tls_t;
+
 /* -------------------------------------------------------------------------- */
 /*                                   声明                                     */
 /* -------------------------------------------------------------------------- */
 
+#ifdef MP_INLINE_BUF
 /**
- * @brief 内存池初始化
+ * @brief 内存池初始化, 使用内嵌缓冲区与首次适配策略
  *
  * @param mp
  */
 HAPI void mp_init(mp_t *mp);
 
+/**
+ * @brief 内存池初始化, 使用内嵌缓冲区, 指定分配策略
+ *
+ * @param mp
+ * @param e_policy
+ */
+HAPI void mp_init_policy(mp_t *mp, mp_policy_e e_policy);
+#endif
+
+/**
+ * @brief 内存池初始化, 在调用方提供的缓冲区上管理内存, 使用首次适配策略
+ *
+ * 其它策略在分配前以 mp_set_policy 设置.
+ *
+ * @param mp
+ * @param base 缓冲区, 起始地址不足 MP_ALIGN 对齐时向后调整
+ * @param size 缓冲区大小
+ */
+HAPI void mp_init_ext(mp_t *mp, void *base, usz size);
+
+/**
+ * @brief 切换分配策略并回收整个内存池, 之前分配的内存全部失效
+ *
+ * @param mp
+ * @param e_policy
+ */
+HAPI void mp_set_policy(mp_t *mp, mp_policy_e e_policy);
+
 /**
  * @brief 从内存池分配 cap 字节
  *
@@ -61,22 +236,140 @@ HAPI void *mp_calloc(mp_t *mp, usz cap);
  */
 HAPI void mp_free(mp_t *mp, void *ptr);
 
+/**
+ * @brief 回收整个内存池, 之前分配的内存全部失效
+ *
+ * @param mp
+ */
+HAPI void mp_reset(mp_t *mp);
+
+/**
+ * @brief 将当前线程在 mp 上的缓存块归还全局池
+ *
+ * @param mp
+ */
+HAPI void mp_mag_flush(mp_t *mp);
+
+/**
+ * @brief 将当前线程所有缓存块归还各自的内存池, 线程退出前调用
+ */
+HAPI void mp_mag_flush_all(void);
+
+/**
+ * @brief 读取统计快照, 只在读取空闲位图时短暂持锁, O(1), 可在周期任务中调用
+ *
+ * 未定义 MP_STATS 时只有 largest_free 有效, 其余项为 0.
+ *
+ * @param mp
+ * @param stats
+ */
+HAPI void mp_stats_snapshot(mp_t *mp, mp_stats_t *stats);
+
+#ifdef __linux__
+/**
+ * @brief 映射内存池缓冲区
+ *
+ * @param size 输入申请大小, 输出实际映射大小 (页或大页对齐), 释放时传给 mp_unmap
+ * @param flags MP_MAP_* 组合
+ * @return 缓冲区起始地址, 失败返回 NULL
+ */
+HAPI void *mp_map(usz *size, u32 flags);
+
+/**
+ * @brief 释放 mp_map 映射的缓冲区
+ *
+ * @param base
+ * @param size mp_map 输出的实际映射大小
+ */
+HAPI void mp_unmap(void *base, usz size);
+#endif
+
 /* -------------------------------------------------------------------------- */
 /*                                   定义                                     */
 /* -------------------------------------------------------------------------- */
 
+#ifdef MP_INLINE_BUF
 HAPI void
 mp_init(mp_t *mp)
 {
-        list_init(&mp->blk_root);
+        mp_init_ext(mp, mp->buf, MP_SIZE);
+}
+
+HAPI void
+mp_init_policy(mp_t *mp, const mp_policy_e e_policy)
+{
+        mp_init_ext(mp, mp->buf, MP_SIZE);
+        mp_set_policy(mp, e_policy);
+}
+#endif
+
+HAPI void
+mp_init_ext(mp_t *mp, void *base, usz size)
+{
+        const usz pad = (MP_ALIGN - ((uintptr_t)base & (MP_ALIGN - 1))) & (MP_ALIGN - 1);
+        size          = (size > pad) ? (size - pad) & ~(usz)(MP_ALIGN - 1) : 0;
+
+        mp->base     = (u8 *)base + pad;
+        mp->cap      = size;
+        mp->e_policy = MP_POLICY_FIRST_FIT;
+        ATOMIC_STORE_EXPLICIT(&mp->lock, 0, memory_order_relaxed);
+#ifdef MP_STATS
+        mp_counter_t *stats = &mp->stats;
+        ATOMIC_STORE_EXPLICIT(&stats->peak_bytes, 0, memory_order_relaxed);
+        ATOMIC_STORE_EXPLICIT(&stats->alloc_cnt, 0, memory_order_relaxed);
+        ATOMIC_STORE_EXPLICIT(&stats->free_cnt, 0, memory_order_relaxed);
+        ATOMIC_STORE_EXPLICIT(&stats->fail_cnt, 0, memory_order_relaxed);
+        for (usz i = 0; i < MP_HIST_NUM; i++) {
+                ATOMIC_STORE_EXPLICIT(&stats->alloc_hist[i], 0, memory_order_relaxed);
+                ATOMIC_STORE_EXPLICIT(&stats->free_hist[i], 0, memory_order_relaxed);
+        }
+#endif
+        mp_reset(mp);
+}
+
+HAPI void
+mp_set_policy(mp_t *mp, const mp_policy_e e_policy)
+{
+        mp->e_policy = e_policy;
+        mp_reset(mp);
 }
 
+/* 从未使用区域线性切出 block_size 字节, 调用方持锁 */
 HAPI void *
-mp_alloc(mp_t *mp, usz cap)
+mp_bump(mp_t *mp, const usz block_size)
 {
-        const usz block_size = MP_BLOCK_HEADER_SIZE + MP_ALIGN_UP(cap);
+        if (mp->off + block_size > mp->cap)
+                return NULL; // 内存池耗尽
 
-        SPIN_LOCK(&mp->lock);
+        void *blk  = &mp->base[mp->off];
+        mp->off   += block_size;
+        return blk;
+}
+
+/* 首次适配空闲链表加入/移除 size 字节的块时更新分级计数, 调用方持锁 */
+HAPI void
+mp_ff_bin_add(mp_t *mp, const usz size)
+{
+        const u32 bin = 63 - clz64((u64)size);
+        if (mp->ff_num[bin]++ == 0)
+                mp->ff_map |= 1ULL << bin;
+        MP_STAT_ADD(mp, free_blocks, 1);
+}
+
+HAPI void
+mp_ff_bin_sub(mp_t *mp, const usz size)
+{
+        const u32 bin = 63 - clz64((u64)size);
+        if (--mp->ff_num[bin] == 0)
+                mp->ff_map &= ~(1ULL << bin);
+        MP_STAT_SUB(mp, free_blocks, 1);
+}
+
+/* 首次适配分配, 调用方持锁 */
+HAPI void *
+mp_ff_alloc(mp_t *mp, const usz cap)
+{
+        const usz block_size = MP_BLOCK_HEADER_SIZE + MP_ALIGN_UP(cap);
 
         // 查找能满足申请大小 block_size 的空闲块
         list_head_t *node;
@@ -89,6 +382,7 @@ mp_alloc(mp_t *mp, usz cap)
                 if (blk->size >= block_size + MP_BLOCK_HEADER_SIZE + MP_ALIGN) {
                         // 能切分出一个新的空闲块: 先移除原块
                         list_del(node);
+                        mp_ff_bin_sub(mp, blk->size);
 
                         // 从剩余空间生成 split_blk 并按地址顺序插回空闲链表
                         mp_blk_t *split_blk = (mp_blk_t *)((u8 *)blk + block_size);
@@ -100,27 +394,464 @@ mp_alloc(mp_t *mp, usz cap)
                                 iter = iter->next;
 
                         __list_add(&split_blk->blk_node, iter->prev, iter);
-                } else
+                        mp_ff_bin_add(mp, split_blk->size);
+                } else {
                         list_del(node); // 无法切分时直接整块取出
-
-                SPIN_UNLOCK(&mp->lock);
+                        mp_ff_bin_sub(mp, blk->size);
+                }
 
                 // 返回指向用户数据区域的指针 (跳过块头)
-                return (u8 *)blk + MP_BLOCK_HEADER_SIZE;
+                u8 *ptr         = (u8 *)blk + MP_BLOCK_HEADER_SIZE;
+                MP_BLK_TAG(ptr) = blk->size;
+                return ptr;
         }
 
         // 空闲链表没有合适块，则尝试向后线性分配
-        if (mp->off + block_size > MP_SIZE) {
+        mp_blk_t *fresh_blk = (mp_blk_t *)mp_bump(mp, block_size);
+        if (!fresh_blk)
+                return NULL;
+
+        fresh_blk->size = block_size;
+
+        u8 *ptr         = (u8 *)fresh_blk + MP_BLOCK_HEADER_SIZE;
+        MP_BLK_TAG(ptr) = block_size;
+        return ptr;
+}
+
+/* 首次适配释放, 调用方持锁 */
+HAPI void
+mp_ff_free(mp_t *mp, void *ptr)
+{
+        // 回退到块头部，恢复块结构
+        mp_blk_t *block = (mp_blk_t *)((u8 *)ptr - MP_BLOCK_HEADER_SIZE);
+
+        // 将释放块按地址顺序插入空闲链表，方便后续合并
+        list_head_t *pos = mp->blk_root.next;
+        while (pos != &mp->blk_root && (u8 *)CONTAINER_OF(pos, mp_blk_t, blk_node) < (u8 *)block)
+                pos = pos->next;
+
+        __list_add(&block->blk_node, pos->prev, pos);
+        mp_ff_bin_add(mp, block->size);
+}
+
+/**
+ * @brief 计算块大小所属的 slab 尺寸级别
+ *
+ * @param block_size 包含标签的块大小
+ * @return 尺寸级别, 超出最大级别返回 MP_SLAB_CLASS_NUM
+ */
+HAPI u32
+mp_slab_cls(const usz block_size)
+{
+        if (block_size <= ((usz)1 << MP_SLAB_SHIFT_MIN))
+                return 0;
+
+        const u32 shift = 64 - clz64((u64)block_size - 1); // ceil(log2(block_size))
+        return (shift > MP_SLAB_SHIFT_MAX) ? MP_SLAB_CLASS_NUM : shift - MP_SLAB_SHIFT_MIN;
+}
+
+/**
+ * @brief slab 分配, 调用方持锁
+ *
+ * 依次尝试: 本级空闲栈, 线性切出新块, 拆分更大级别的空闲块.
+ * 尺寸级别数量固定, 三条路径都是 O(1).
+ *
+ * @param mp
+ * @param cls 尺寸级别
+ * @return 指向用户数据区域的指针, 失败返回 NULL
+ */
+HAPI void *
+mp_slab_alloc(mp_t *mp, const u32 cls)
+{
+        const usz block_size = (usz)1 << (cls + MP_SLAB_SHIFT_MIN);
+
+        u8 *blk = (u8 *)mp->slab_root[cls];
+        if (blk) {
+                blk                -= MP_TAG_SIZE;
+                mp->slab_root[cls]  = mp->slab_root[cls]->next;
+                MP_STAT_SUB(mp, free_blocks, 1);
+        } else
+                blk = (u8 *)mp_bump(mp, block_size);
+
+        if (!blk) {
+                // 线性区域耗尽, 从更大级别取一块对半拆分, 上半部分逐级挂回空闲栈
+                u32 src = cls + 1;
+                while (src < MP_SLAB_CLASS_NUM && !mp->slab_root[src])
+                        src++;
+                if (src == MP_SLAB_CLASS_NUM)
+                        return NULL;
+
+                blk                = (u8 *)mp->slab_root[src] - MP_TAG_SIZE;
+                mp->slab_root[src] = mp->slab_root[src]->next;
+                MP_STAT_SUB(mp, free_blocks, 1);
+                while (src-- > cls) {
+                        u8             *half = blk + ((usz)1 << (src + MP_SLAB_SHIFT_MIN));
+                        mp_slab_node_t *node = (mp_slab_node_t *)(half + MP_TAG_SIZE);
+                        node->next           = mp->slab_root[src];
+                        mp->slab_root[src]   = node;
+                        MP_STAT_ADD(mp, free_blocks, 1);
+                }
+        }
+
+        u8 *ptr         = blk + MP_TAG_SIZE;
+        MP_BLK_TAG(ptr) = block_size | MP_TAG_SLAB;
+        return ptr;
+}
+
+/* slab 释放, 调用方持锁 */
+HAPI void
+mp_slab_free(mp_t *mp, void *ptr)
+{
+        const u32       cls  = mp_slab_cls(MP_BLK_TAG(ptr) & ~(usz)MP_TAG_SLAB);
+        mp_slab_node_t *node = (mp_slab_node_t *)ptr;
+
+        node->next         = mp->slab_root[cls];
+        mp->slab_root[cls] = node;
+        MP_STAT_ADD(mp, free_blocks, 1);
+}
+
+/* 块大小映射到 (fl, sl) */
+HAPI void
+mp_tlsf_mapping(const usz size, u32 *fl, u32 *sl)
+{
+        if (size < MP_TLSF_SMALL) {
+                *fl = 0;
+                *sl = (u32)(size / (MP_TLSF_SMALL / MP_TLSF_SL_COUNT));
+        } else {
+                const u32 fls = 63 - clz64((u64)size);
+                *sl           = (u32)(size >> (fls - MP_TLSF_SL_LOG2)) ^ MP_TLSF_SL_COUNT;
+                *fl           = fls - (MP_TLSF_FL_SHIFT - 1);
+        }
+}
+
+HAPI usz
+mp_tlsf_size(const mp_tlsf_blk_t *blk)
+{
+        return blk->size & ~(usz)MP_TAG_MASK;
+}
+
+HAPI mp_tlsf_blk_t *
+mp_tlsf_next(const mp_tlsf_blk_t *blk)
+{
+        return (mp_tlsf_blk_t *)((u8 *)blk + mp_tlsf_size(blk));
+}
+
+HAPI void
+mp_tlsf_insert(mp_t *mp, mp_tlsf_blk_t *blk)
+{
+        u32 fl, sl;
+        mp_tlsf_mapping(mp_tlsf_size(blk), &fl, &sl);
+
+        blk->prev_free = NULL;
+        blk->next_free = mp->tlsf_root[fl][sl];
+        if (blk->next_free)
+                blk->next_free->prev_free = blk;
+
+        mp->tlsf_root[fl][sl]  = blk;
+        mp->tlsf_fl_map       |= 1U << fl;
+        mp->tlsf_sl_map[fl]   |= 1U << sl;
+        MP_STAT_ADD(mp, free_blocks, 1);
+}
+
+HAPI void
+mp_tlsf_remove(mp_t *mp, mp_tlsf_blk_t *blk)
+{
+        u32 fl, sl;
+        mp_tlsf_mapping(mp_tlsf_size(blk), &fl, &sl);
+
+        if (blk->prev_free)
+                blk->prev_free->next_free = blk->next_free;
+        else
+                mp->tlsf_root[fl][sl] = blk->next_free;
+        if (blk->next_free)
+                blk->next_free->prev_free = blk->prev_free;
+
+        if (!mp->tlsf_root[fl][sl]) {
+                mp->tlsf_sl_map[fl] &= ~(1U << sl);
+                if (!mp->tlsf_sl_map[fl])
+                        mp->tlsf_fl_map &= ~(1U << fl);
+        }
+        MP_STAT_SUB(mp, free_blocks, 1);
+}
+
+/**
+ * @brief 查找不小于 size 的空闲块
+ *
+ * size 先向上取整到所在二级区间的上界, 这样区间内任意一块都满足申请, 无需遍历链表.
+ *
+ * @param mp
+ * @param size
+ * @return 空闲块, 没有满足的块时返回 NULL
+ */
+HAPI mp_tlsf_blk_t *
+mp_tlsf_find(mp_t *mp, usz size)
+{
+        if (size >= MP_TLSF_SMALL)
+                size += ((usz)1 << (63 - clz64((u64)size) - MP_TLSF_SL_LOG2)) - 1;
+
+        u32 fl, sl;
+        mp_tlsf_mapping(size, &fl, &sl);
+        if (fl >= MP_TLSF_FL_COUNT)
+                return NULL;
+
+        u32 sl_map = mp->tlsf_sl_map[fl] & (~0U << sl);
+        if (!sl_map) {
+                const u32 fl_map = (fl + 1 < 32) ? mp->tlsf_fl_map & (~0U << (fl + 1)) : 0;
+                if (!fl_map)
+                        return NULL;
+
+                fl     = ctz32(fl_map);
+                sl_map = mp->tlsf_sl_map[fl];
+        }
+
+        return mp->tlsf_root[fl][ctz32(sl_map)];
+}
+
+/* 将 [base, base + size) 初始化为一个空闲块和末尾的哨兵块, 调用方持锁 */
+HAPI void
+mp_tlsf_setup(mp_t *mp, u8 *base, const usz size)
+{
+        mp->tlsf_fl_map = 0;
+        memset(mp->tlsf_sl_map, 0, sizeof(mp->tlsf_sl_map));
+        memset(mp->tlsf_root, 0, sizeof(mp->tlsf_root));
+
+        if (size < MP_TLSF_HDR_SIZE + MP_TLSF_BLK_MIN)
+                return;
+
+        mp_tlsf_blk_t *blk = (mp_tlsf_blk_t *)base;
+        blk->prev_phys     = NULL;
+        blk->size          = ((size & ~(usz)MP_TAG_MASK) - MP_TLSF_HDR_SIZE) | MP_TAG_FREE;
+
+        // 哨兵块只有头部, 标记为已使用, 合并到此为止
+        mp_tlsf_blk_t *sentinel = mp_tlsf_next(blk);
+        sentinel->prev_phys     = blk;
+        sentinel->size          = 0;
+
+        mp_tlsf_insert(mp, blk);
+}
+
+/* tlsf 分配, 调用方持锁 */
+HAPI void *
+mp_tlsf_alloc(mp_t *mp, const usz cap)
+{
+        const usz need = MAX(MP_TLSF_HDR_SIZE + MP_ALIGN_UP(cap), MP_TLSF_BLK_MIN);
+
+        mp_tlsf_blk_t *blk = mp_tlsf_find(mp, need);
+        if (!blk)
+                return NULL;
+
+        mp_tlsf_remove(mp, blk);
+
+        const usz size = mp_tlsf_size(blk);
+        if (size - need >= MP_TLSF_BLK_MIN) {
+                // 剩余部分切分为新的空闲块
+                mp_tlsf_blk_t *split = (mp_tlsf_blk_t *)((u8 *)blk + need);
+                split->prev_phys     = blk;
+                split->size          = (size - need) | MP_TAG_FREE;
+                blk->size            = need;
+
+                mp_tlsf_next(split)->prev_phys = split;
+                mp_tlsf_insert(mp, split);
+        } else
+                blk->size = size;
+
+        return (u8 *)blk + MP_TLSF_HDR_SIZE;
+}
+
+/* tlsf 释放并与物理相邻的空闲块合并, 调用方持锁 */
+HAPI void
+mp_tlsf_free(mp_t *mp, void *ptr)
+{
+        mp_tlsf_blk_t *blk  = (mp_tlsf_blk_t *)((u8 *)ptr - MP_TLSF_HDR_SIZE);
+        mp_tlsf_blk_t *prev = blk->prev_phys;
+        mp_tlsf_blk_t *next = mp_tlsf_next(blk);
+        usz            size = mp_tlsf_size(blk);
+
+        if (prev && (prev->size & MP_TAG_FREE)) {
+                mp_tlsf_remove(mp, prev);
+                size += mp_tlsf_size(prev);
+                blk   = prev;
+        }
+        if (next->size & MP_TAG_FREE) {
+                mp_tlsf_remove(mp, next);
+                size += mp_tlsf_size(next);
+        }
+
+        blk->size                    = size | MP_TAG_FREE;
+        mp_tlsf_next(blk)->prev_phys = blk;
+        mp_tlsf_insert(mp, blk);
+}
+
+HAPI mp_mag_tls_t *
+mp_mag_tls(void)
+{
+        static THREAD_LOCAL mp_mag_tls_t tls[MP_MAG_TLS_MAX];
+        return tls;
+}
+
+/**
+ * @brief 获取当前线程在 mp 上的缓存, 首次调用时占用一个空闲槽位
+ *
+ * @param mp
+ * @return 缓存, 线程缓存槽位已满时返回 NULL (直接访问全局池)
+ */
+HAPI mp_mag_tls_t *
+mp_mag_get(mp_t *mp)
+{
+        mp_mag_tls_t *tls  = mp_mag_tls();
+        mp_mag_tls_t *slot = NULL;
+        for (usz i = 0; i < MP_MAG_TLS_MAX; i++) {
+                if (tls[i].mp == mp) {
+                        slot = &tls[i];
+                        break;
+                }
+                if (!tls[i].mp && !slot)
+                        slot = &tls[i];
+        }
+        if (!slot)
+                return NULL;
+
+        // 新占用或 mp_reset 之后, 缓存块已经失效
+        if (slot->mp != mp || slot->gen != mp->gen) {
+                memset(slot, 0, sizeof(*slot));
+                slot->mp  = mp;
+                slot->gen = mp->gen;
+        }
+        return slot;
+}
+
+/* 从全局池批量补充 magazine, 返回缓存块 */
+HAPI void *
+mp_mag_alloc(mp_t *mp, mp_mag_t *mag, const u32 cls)
+{
+        if (mag->cnt == 0) {
+                SPIN_LOCK(&mp->lock);
+                while (mag->cnt < MP_MAG_SIZE / 2) {
+                        void *ptr = mp_slab_alloc(mp, cls);
+                        if (!ptr)
+                                break;
+                        mag->blks[mag->cnt++] = ptr;
+                }
                 SPIN_UNLOCK(&mp->lock);
-                return NULL; // 内存池耗尽
+
+                if (mag->cnt == 0)
+                        return NULL;
+        }
+
+        return mag->blks[--mag->cnt];
+}
+
+/* 放入 magazine, 放满时先批量归还一半 */
+HAPI void
+mp_mag_free(mp_t *mp, mp_mag_t *mag, void *ptr)
+{
+        if (mag->cnt == MP_MAG_SIZE) {
+                SPIN_LOCK(&mp->lock);
+                while (mag->cnt > MP_MAG_SIZE / 2)
+                        mp_slab_free(mp, mag->blks[--mag->cnt]);
+                SPIN_UNLOCK(&mp->lock);
+        }
+
+        mag->blks[mag->cnt++] = ptr;
+}
+
+HAPI void
+mp_mag_flush_tls(mp_mag_tls_t *tls)
+{
+        mp_t *mp = tls->mp;
+        if (mp && tls->gen == mp->gen) {
+                SPIN_LOCK(&mp->lock);
+                for (u32 cls = 0; cls < MP_SLAB_CLASS_NUM; cls++) {
+                        mp_mag_t *mag = &tls->mags[cls];
+                        while (mag->cnt > 0)
+                                mp_slab_free(mp, mag->blks[--mag->cnt]);
+                }
+                SPIN_UNLOCK(&mp->lock);
+        }
+
+        memset(tls, 0, sizeof(*tls));
+}
+
+HAPI void
+mp_mag_flush(mp_t *mp)
+{
+        mp_mag_tls_t *tls = mp_mag_tls();
+        for (usz i = 0; i < MP_MAG_TLS_MAX; i++) {
+                if (tls[i].mp == mp)
+                        mp_mag_flush_tls(&tls[i]);
         }
+}
+
+HAPI void
+mp_mag_flush_all(void)
+{
+        mp_mag_tls_t *tls = mp_mag_tls();
+        for (usz i = 0; i < MP_MAG_TLS_MAX; i++)
+                mp_mag_flush_tls(&tls[i]);
+}
+
+HAPI void *
+mp_do_alloc(mp_t *mp, usz cap)
+{
+        void *ptr;
 
-        mp_blk_t *fresh_blk  = (mp_blk_t *)&mp->buf[mp->off];
-        fresh_blk->size      = block_size;
-        mp->off             += block_size;
+        const u32 cls = (mp->e_policy == MP_POLICY_SLAB) ? mp_slab_cls(MP_TAG_SIZE + MP_ALIGN_UP(cap)) : MP_SLAB_CLASS_NUM;
+
+#ifdef MP_MAGAZINE
+        if (cls < MP_SLAB_CLASS_NUM) {
+                mp_mag_tls_t *tls = mp_mag_get(mp);
+                if (tls)
+                        return mp_mag_alloc(mp, &tls->mags[cls], cls);
+        }
+#endif
+
+        SPIN_LOCK(&mp->lock);
+
+        if (cls < MP_SLAB_CLASS_NUM)
+                ptr = mp_slab_alloc(mp, cls);
+        else if (mp->e_policy == MP_POLICY_TLSF)
+                ptr = mp_tlsf_alloc(mp, cap);
+        else
+                ptr = mp_ff_alloc(mp, cap); // 首次适配或超出 slab 最大级别
 
         SPIN_UNLOCK(&mp->lock);
-        return (u8 *)fresh_blk + MP_BLOCK_HEADER_SIZE;
+        return ptr;
+}
+
+#ifdef MP_STATS
+HAPI u32
+mp_stats_bucket(const u64 ns)
+{
+        const u32 bucket = 63 - clz64(ns | 1);
+        return MIN(bucket, MP_HIST_NUM - 1);
+}
+#endif
+
+HAPI void *
+mp_alloc(mp_t *mp, usz cap)
+{
+#ifdef MP_STATS
+        const u64 begin_ns = get_mono_ts_ns();
+        void     *ptr      = mp_do_alloc(mp, cap);
+        const u64 end_ns   = get_mono_ts_ns();
+
+        MP_STAT_ADD(mp, alloc_hist[mp_stats_bucket(end_ns - begin_ns)], 1);
+        if (!ptr) {
+                MP_STAT_ADD(mp, fail_cnt, 1);
+                return NULL;
+        }
+
+        const usz size = MP_BLK_TAG(ptr) & ~(usz)MP_TAG_MASK;
+        const usz live = MP_STAT_ADD(mp, live_bytes, size) + size;
+        usz       peak = ATOMIC_LOAD_EXPLICIT(&mp->stats.peak_bytes, memory_order_relaxed);
+        while (peak < live &&
+               !ATOMIC_CAS_WEAK_EXPLICIT(&mp->stats.peak_bytes, &peak, live, memory_order_relaxed, memory_order_relaxed))
+                ;
+        MP_STAT_ADD(mp, alloc_cnt, 1);
+        return ptr;
+#else
+        return mp_do_alloc(mp, cap);
+#endif
 }
 
 HAPI void *
@@ -134,25 +865,110 @@ mp_calloc(mp_t *mp, const usz cap)
         return ptr;
 }
 
+HAPI void
+mp_do_free(mp_t *mp, void *ptr)
+{
+#ifdef MP_MAGAZINE
+        if (MP_BLK_TAG(ptr) & MP_TAG_SLAB) {
+                mp_mag_tls_t *tls = mp_mag_get(mp);
+                if (tls) {
+                        const u32 cls = mp_slab_cls(MP_BLK_TAG(ptr) & ~(usz)MP_TAG_SLAB);
+                        mp_mag_free(mp, &tls->mags[cls], ptr);
+                        return;
+                }
+        }
+#endif
+
+        SPIN_LOCK(&mp->lock);
+
+        if (MP_BLK_TAG(ptr) & MP_TAG_SLAB)
+                mp_slab_free(mp, ptr);
+        else if (mp->e_policy == MP_POLICY_TLSF)
+                mp_tlsf_free(mp, ptr);
+        else
+                mp_ff_free(mp, ptr);
+
+        SPIN_UNLOCK(&mp->lock);
+}
+
 HAPI void
 mp_free(mp_t *mp, void *ptr)
 {
         if (!ptr)
                 return;
 
-        // 回退到块头部，恢复块结构
-        mp_blk_t *block = (mp_blk_t *)((u8 *)ptr - MP_BLOCK_HEADER_SIZE);
+#ifdef MP_STATS
+        const usz size     = MP_BLK_TAG(ptr) & ~(usz)MP_TAG_MASK;
+        const u64 begin_ns = get_mono_ts_ns();
+        mp_do_free(mp, ptr);
+        const u64 end_ns = get_mono_ts_ns();
 
-        SPIN_LOCK(&mp->lock);
+        MP_STAT_ADD(mp, free_hist[mp_stats_bucket(end_ns - begin_ns)], 1);
+        MP_STAT_SUB(mp, live_bytes, size);
+        MP_STAT_ADD(mp, free_cnt, 1);
+#else
+        mp_do_free(mp, ptr);
+#endif
+}
 
-        // 将释放块按地址顺序插入空闲链表，方便后续合并
-        list_head_t *pos = mp->blk_root.next;
-        while (pos != &mp->blk_root && (u8 *)CONTAINER_OF(pos, mp_blk_t, blk_node) < (u8 *)block)
-                pos = pos->next;
+/*
+ * 最大空闲块的下界, 调用方持锁. 只读位图, O(1):
+ *  - 首次适配链表按 2^n 分级, 取最高非空级的下界 (与实际最大块相差不到一倍);
+ *  - slab 取最高非空尺寸级别;
+ *  - tlsf 取最高非空二级区间的下界, 即 mp_alloc 保证能满足的最大块.
+ */
+HAPI usz
+mp_largest_free(mp_t *mp)
+{
+        usz largest = mp->cap - mp->off; // 线性区域剩余
 
-        __list_add(&block->blk_node, pos->prev, pos);
+        // slab 模式下超出最大级别的块也在首次适配链表中
+        if (mp->ff_map)
+                largest = MAX(largest, (usz)1 << (63 - clz64(mp->ff_map)));
 
+        if (mp->e_policy == MP_POLICY_SLAB) {
+                for (u32 cls = MP_SLAB_CLASS_NUM; cls-- > 0;) {
+                        if (mp->slab_root[cls]) {
+                                largest = MAX(largest, (usz)1 << (cls + MP_SLAB_SHIFT_MIN));
+                                break;
+                        }
+                }
+        }
+
+        if (mp->e_policy == MP_POLICY_TLSF && mp->tlsf_fl_map) {
+                const u32 fl = 31 - clz32(mp->tlsf_fl_map);
+                const u32 sl = 31 - clz32(mp->tlsf_sl_map[fl]);
+                if (fl == 0) {
+                        largest = MAX(largest, (usz)sl * (MP_TLSF_SMALL / MP_TLSF_SL_COUNT));
+                } else {
+                        const u32 fls = fl + MP_TLSF_FL_SHIFT - 1;
+                        largest       = MAX(largest, ((usz)1 << fls) + ((usz)sl << (fls - MP_TLSF_SL_LOG2)));
+                }
+        }
+        return largest;
+}
+
+HAPI void
+mp_stats_snapshot(mp_t *mp, mp_stats_t *stats)
+{
+        memset(stats, 0, sizeof(*stats));
+
+        SPIN_LOCK(&mp->lock);
+        stats->largest_free = mp_largest_free(mp);
         SPIN_UNLOCK(&mp->lock);
+
+#ifdef MP_STATS
+        stats->live_bytes  = ATOMIC_LOAD_EXPLICIT(&mp->stats.live_bytes, memory_order_relaxed);
+        stats->peak_bytes  = ATOMIC_LOAD_EXPLICIT(&mp->stats.peak_bytes, memory_order_relaxed);
+        stats->free_blocks = ATOMIC_LOAD_EXPLICIT(&mp->stats.free_blocks, memory_order_relaxed);
+        stats->alloc_cnt   = ATOMIC_LOAD_EXPLICIT(&mp->stats.alloc_cnt, memory_order_relaxed);
+        stats->free_cnt    = ATOMIC_LOAD_EXPLICIT(&mp->stats.free_cnt, memory_order_relaxed);
+        stats->fail_cnt    = ATOMIC_LOAD_EXPLICIT(&mp->stats.fail_cnt, memory_order_relaxed);
+        for (usz i = 0; i < MP_HIST_NUM; i++) {
+                stats->alloc_hist[i] = ATOMIC_LOAD_EXPLICIT(&mp->stats.alloc_hist[i], memory_order_relaxed);
+                stats->free_hist[i]  = ATOMIC_LOAD_EXPLICIT(&mp->stats.free_hist[i], memory_order_relaxed);
+        }
+#endif
 }
 
 HAPI void
@@ -161,7 +977,68 @@ mp_reset(mp_t *mp)
         SPIN_LOCK(&mp->lock);
         mp->off = 0;              // 回收整块缓冲区
         list_init(&mp->blk_root); // 清空空闲链表
+        mp->ff_map = 0;
+        memset(mp->ff_num, 0, sizeof(mp->ff_num));
+        memset(mp->slab_root, 0, sizeof(mp->slab_root));
+#ifdef MP_STATS
+        ATOMIC_STORE_EXPLICIT(&mp->stats.live_bytes, 0, memory_order_relaxed);
+        ATOMIC_STORE_EXPLICIT(&mp->stats.free_blocks, 0, memory_order_relaxed);
+#endif
+        if (mp->e_policy == MP_POLICY_TLSF) {
+                mp_tlsf_setup(mp, mp->base, mp->cap);
+                mp->off = mp->cap; // tlsf 不使用线性分配
+        }
+        mp->gen++; // 各线程缓存在下次访问时丢弃
         SPIN_UNLOCK(&mp->lock);
 }
 
+#ifdef __linux__
+HAPI void *
+mp_map(usz *size, const u32 flags)
+{
+        const int prot     = PROT_READ | PROT_WRITE;
+        const int populate = (flags & MP_MAP_POPULATE) ? MAP_POPULATE : 0;
+        void     *base     = MAP_FAILED;
+
+        if (flags & MP_MAP_HUGETLB) {
+                const usz huge_size = (*size + MP_HUGEPAGE_SIZE - 1) & ~(usz)(MP_HUGEPAGE_SIZE - 1);
+
+                base = mmap(NULL, huge_size, prot, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | populate, -1, 0);
+                if (base != MAP_FAILED)
+                        *size = huge_size;
+        }
+
+        if (base == MAP_FAILED) {
+                const usz page_size = (usz)sysconf(_SC_PAGESIZE);
+                *size               = (*size + page_size - 1) & ~(page_size - 1);
+
+                // 退回普通页时尽量使用透明大页, 需在缺页前设置, 因此改为写入预缺页
+                const bool thp = flags & MP_MAP_HUGETLB;
+
+                base = mmap(NULL, *size, prot, MAP_PRIVATE | MAP_ANONYMOUS | (thp ? 0 : populate), -1, 0);
+                if (base == MAP_FAILED)
+                        return NULL;
+
+                if (thp) {
+                        madvise(base, *size, MADV_HUGEPAGE);
+                        if (populate)
+                                memset(base, 0, *size);
+                }
+        }
+
+        if ((flags & MP_MAP_LOCK) && mlock(base, *size) != 0) {
+                munmap(base, *size);
+                return NULL;
+        }
+        return base;
+}
+
+HAPI void
+mp_unmap(void *base, const usz size)
+{
+        munlock(base, size);
+        munmap(base, size);
+}
+#endif
+
 #endif // !MP_H
@@ -0,0 +1,217 @@
+#ifndef MPMC_H
+#define MPMC_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "../util/macrodef.h"
+#include "../util/mathdef.h"
+#include "../util/typedef.h"
+
+/*
+ * 有界无锁多生产者多消费者队列 (Vyukov).
+ * 每个单元带有序号 seq, 位置 pos 的单元在 seq == pos 时可写, seq == pos + 1 时可读,
+ * 读出后置为 pos + cap 供下一轮写入. 生产者与消费者只在各自的位置上竞争 CAS.
+ */
+
+#define MPMC_CELL_ALIGN               (sizeof(usz))
+#define MPMC_CELL_SIZE(elem_size)     ((sizeof(usz) + (elem_size) + MPMC_CELL_ALIGN - 1) & ~(MPMC_CELL_ALIGN - 1))
+#define MPMC_BUF_SIZE(cap, elem_size) ((cap) * MPMC_CELL_SIZE(elem_size)) // 队列所需缓冲区字节数
+
+typedef struct {
+        u8 *buf;       // 单元缓冲区
+        usz cap;       // 单元数量(2^n)
+        usz elem_size; // 槽位大小
+        usz cell_size; // 单元大小 (序号 + 槽位, 按 MPMC_CELL_ALIGN 对齐)
+        CACHELINE_ALIGNED ATOMIC(usz) enq_pos; // 生产者位置
+        CACHELINE_ALIGNED ATOMIC(usz) deq_pos; // 消费者位置
+} mpmc_t;
+
+HAPI int  mpmc_init(mpmc_t *mpmc, void *buf, usz cap, usz elem_size);
+HAPI bool mpmc_push(mpmc_t *mpmc, const void *src);
+HAPI bool mpmc_pop(mpmc_t *mpmc, void *dst);
+HAPI usz  mpmc_push_n(mpmc_t *mpmc, const void *src, usz n);
+HAPI usz  mpmc_pop_n(mpmc_t *mpmc, void *dst, usz n);
+HAPI usz  mpmc_avail(mpmc_t *mpmc);
+
+HAPI ATOMIC(usz) *
+mpmc_cell_seq(mpmc_t *mpmc, const usz pos)
+{
+        return (ATOMIC(usz) *)(mpmc->buf + (pos & (mpmc->cap - 1)) * mpmc->cell_size);
+}
+
+HAPI void *
+mpmc_cell_data(mpmc_t *mpmc, const usz pos)
+{
+        return mpmc->buf + (pos & (mpmc->cap - 1)) * mpmc->cell_size + sizeof(usz);
+}
+
+/**
+ * @brief 初始化队列
+ *
+ * @param mpmc
+ * @param buf 至少 MPMC_BUF_SIZE(cap, elem_size) 字节, 按 MPMC_CELL_ALIGN 对齐
+ * @param cap 单元数量(2^n)
+ * @param elem_size 槽位大小
+ * @return 0 成功, -1 cap 不是 2^n
+ */
+HAPI int
+mpmc_init(mpmc_t *mpmc, void *buf, const usz cap, const usz elem_size)
+{
+        if (!IS_POWER_OF_2(cap))
+                return -1;
+
+        mpmc->buf       = (u8 *)buf;
+        mpmc->cap       = cap;
+        mpmc->elem_size = elem_size;
+        mpmc->cell_size = MPMC_CELL_SIZE(elem_size);
+
+        for (usz i = 0; i < cap; i++)
+                ATOMIC_STORE_EXPLICIT(mpmc_cell_seq(mpmc, i), i, memory_order_relaxed);
+
+        ATOMIC_STORE_EXPLICIT(&mpmc->enq_pos, 0, memory_order_relaxed);
+        ATOMIC_STORE_EXPLICIT(&mpmc->deq_pos, 0, memory_order_release);
+        return 0;
+}
+
+HAPI bool
+mpmc_push(mpmc_t *mpmc, const void *src)
+{
+        usz pos = ATOMIC_LOAD_EXPLICIT(&mpmc->enq_pos, memory_order_relaxed);
+        for (;;) {
+                const usz seq  = ATOMIC_LOAD_EXPLICIT(mpmc_cell_seq(mpmc, pos), memory_order_acquire);
+                const isz diff = (isz)seq - (isz)pos;
+                if (diff == 0) {
+                        if (ATOMIC_CAS_WEAK_EXPLICIT(&mpmc->enq_pos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+                                break;
+                } else if (diff < 0)
+                        return false; // 队列已满
+                else
+                        pos = ATOMIC_LOAD_EXPLICIT(&mpmc->enq_pos, memory_order_relaxed);
+        }
+
+        memcpy(mpmc_cell_data(mpmc, pos), src, mpmc->elem_size);
+        ATOMIC_STORE_EXPLICIT(mpmc_cell_seq(mpmc, pos), pos + 1, memory_order_release);
+        return true;
+}
+
+HAPI bool
+mpmc_pop(mpmc_t *mpmc, void *dst)
+{
+        usz pos = ATOMIC_LOAD_EXPLICIT(&mpmc->deq_pos, memory_order_relaxed);
+        for (;;) {
+                const usz seq  = ATOMIC_LOAD_EXPLICIT(mpmc_cell_seq(mpmc, pos), memory_order_acquire);
+                const isz diff = (isz)seq - (isz)(pos + 1);
+                if (diff == 0) {
+                        if (ATOMIC_CAS_WEAK_EXPLICIT(&mpmc->deq_pos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+                                break;
+                } else if (diff < 0)
+                        return false; // 队列为空
+                else
+                        pos = ATOMIC_LOAD_EXPLICIT(&mpmc->deq_pos, memory_order_relaxed);
+        }
+
+        memcpy(dst, mpmc_cell_data(mpmc, pos), mpmc->elem_size);
+        ATOMIC_STORE_EXPLICIT(mpmc_cell_seq(mpmc, pos), pos + mpmc->cap, memory_order_release);
+        return true;
+}
+
+/**
+ * @brief 一次 CAS 领取从 *pos 开始连续就绪的 k 个位置
+ *
+ * 就绪即单元序号等于 pos + i + lag (写入 lag = 0, 读出 lag = 1). 只领取已就绪的前缀,
+ * 领取成功后这些单元不会再被其它线程修改, 因此无需等待对端.
+ *
+ * @param mpmc
+ * @param idx enq_pos 或 deq_pos
+ * @param pos 输出: 领取的起始位置
+ * @param n 最多领取数量
+ * @param lag
+ * @return 领取数量, 0 表示队列已满(写入)或为空(读出)
+ */
+HAPI usz
+mpmc_claim(mpmc_t *mpmc, ATOMIC(usz) *idx, usz *pos, const usz n, const usz lag)
+{
+        usz cur = ATOMIC_LOAD_EXPLICIT(idx, memory_order_relaxed);
+        for (;;) {
+                usz k = 0;
+                for (; k < n; k++) {
+                        const usz seq  = ATOMIC_LOAD_EXPLICIT(mpmc_cell_seq(mpmc, cur + k), memory_order_acquire);
+                        const isz diff = (isz)seq - (isz)(cur + k + lag);
+                        if (diff != 0) {
+                                if (k == 0 && diff > 0)
+                                        k = SIZE_MAX; // cur 已过期
+                                break;
+                        }
+                }
+
+                if (k == 0)
+                        return 0;
+                if (k == SIZE_MAX) {
+                        cur = ATOMIC_LOAD_EXPLICIT(idx, memory_order_relaxed);
+                        continue;
+                }
+                if (ATOMIC_CAS_WEAK_EXPLICIT(idx, &cur, cur + k, memory_order_relaxed, memory_order_relaxed)) {
+                        *pos = cur;
+                        return k;
+                }
+        }
+}
+
+/**
+ * @brief 批量写入, 一次 CAS 申请连续的空闲单元
+ *
+ * @param mpmc
+ * @param src n 个连续槽位
+ * @param n
+ * @return 实际写入数量, 队列剩余空间不足时只写入前一部分
+ */
+HAPI usz
+mpmc_push_n(mpmc_t *mpmc, const void *src, const usz n)
+{
+        usz       pos;
+        const usz k = mpmc_claim(mpmc, &mpmc->enq_pos, &pos, MIN(n, mpmc->cap), 0);
+
+        for (usz i = 0; i < k; i++) {
+                memcpy(mpmc_cell_data(mpmc, pos + i), (const u8 *)src + i * mpmc->elem_size, mpmc->elem_size);
+                ATOMIC_STORE_EXPLICIT(mpmc_cell_seq(mpmc, pos + i), pos + i + 1, memory_order_release);
+        }
+        return k;
+}
+
+/**
+ * @brief 批量读出, 一次 CAS 领取连续的已写入单元
+ *
+ * @param mpmc
+ * @param dst 至少 n 个连续槽位
+ * @param n
+ * @return 实际读出数量
+ */
+HAPI usz
+mpmc_pop_n(mpmc_t *mpmc, void *dst, const usz n)
+{
+        usz       pos;
+        const usz k = mpmc_claim(mpmc, &mpmc->deq_pos, &pos, MIN(n, mpmc->cap), 1);
+
+        for (usz i = 0; i < k; i++) {
+                memcpy((u8 *)dst + i * mpmc->elem_size, mpmc_cell_data(mpmc, pos + i), mpmc->elem_size);
+                ATOMIC_STORE_EXPLICIT(mpmc_cell_seq(mpmc, pos + i), pos + i + mpmc->cap, memory_order_release);
+        }
+        return k;
+}
+
+/**
+ * @brief 近似可读数量, 仅用于监控
+ *
+ * @param mpmc
+ * @return 已申请但未领取的位置数量
+ */
+HAPI usz
+mpmc_avail(mpmc_t *mpmc)
+{
+        const usz deq_pos = ATOMIC_LOAD_EXPLICIT(&mpmc->deq_pos, memory_order_relaxed);
+        const usz enq_pos = ATOMIC_LOAD_EXPLICIT(&mpmc->enq_pos, memory_order_relaxed);
+        return (enq_pos > deq_pos) ? enq_pos - deq_pos : 0;
+}
+
+#endif // !MPMC_H
@@ -47,6 +47,18 @@ HAPI void      mpsc_push(mpsc_p_t *p);
 HAPI usz       mpsc_pop(mpsc_t *mpsc, usz *off);
 HAPI void      mpsc_release(mpsc_t *mpsc, usz size);
 
+/* 批量消费时一次取出的已提交区域, 回绕时最多两段 */
+typedef struct {
+        usz off[2];  // 区域起始偏移
+        usz size[2]; // 区域长度
+        usz seg;     // 迭代: 当前区域
+        usz pos;     // 迭代: 当前区域内已消费长度
+} mpsc_batch_t;
+
+HAPI usz   mpsc_pop_batch(mpsc_t *mpsc, mpsc_batch_t *batch);
+HAPI void *mpsc_batch_next(mpsc_t *mpsc, mpsc_batch_t *batch, usz size);
+HAPI void  mpsc_release_batch(mpsc_t *mpsc, mpsc_batch_t *batch);
+
 HAPI void
 mpsc_init(mpsc_t *mpsc, void *buf, usz cap, mpsc_p_t *producers, usz nproducers)
 {
@@ -217,6 +229,95 @@ mpsc_release(mpsc_t *mpsc, usz size)
         mpsc->rp               = (write_nbytes == mpsc->cap) ? 0 : write_nbytes;
 }
 
+/**
+ * @brief 消费者一次取出全部已提交的连续区域, 只扫描一次生产者
+ *
+ * @param mpsc
+ * @param batch 输出区域, 随后通过 mpsc_batch_next 原地遍历记录
+ * @return 可读字节总数
+ */
+HAPI usz
+mpsc_pop_batch(mpsc_t *mpsc, mpsc_batch_t *batch)
+{
+        const usz rp = ATOMIC_LOAD_EXPLICIT(&mpsc->rp, memory_order_relaxed);
+        const usz wp = mpsc_get_wp(mpsc) & MPSC_OFFSET_MASK;
+
+        memset(batch, 0, sizeof(*batch));
+        if (rp == wp)
+                return 0;
+
+        // hi: rp 之后最小的未完成申请, lo: 回绕区域 [0, wp) 内最小的未完成申请
+        usz hi = MPSC_OFFSET_MAX, lo = MPSC_OFFSET_MAX;
+        for (usz i = 0; i < mpsc->nproducers; i++) {
+                mpsc_p_t *p = &mpsc->producers[i];
+                if (!ATOMIC_LOAD_EXPLICIT(&p->flag, memory_order_relaxed))
+                        continue;
+
+                const usz reserve_pos = mpsc_get_reserve_pos(p);
+                if (reserve_pos >= rp)
+                        hi = (reserve_pos < hi) ? reserve_pos : hi;
+                else
+                        lo = (reserve_pos < lo) ? reserve_pos : lo;
+        }
+
+        if (wp > rp) {
+                batch->off[0]  = rp;
+                batch->size[0] = ((hi < wp) ? hi : wp) - rp;
+                return batch->size[0];
+        }
+
+        // 回绕: 第一段到 warp_end, 其后没有未完成申请时再取 [0, wp)
+        const usz warp_end = (mpsc->warp_end == MPSC_OFFSET_MAX) ? mpsc->cap : mpsc->warp_end;
+        batch->off[0]      = rp;
+        batch->size[0]     = ((hi < warp_end) ? hi : warp_end) - rp;
+        if (hi == MPSC_OFFSET_MAX) {
+                batch->off[1]  = 0;
+                batch->size[1] = (lo < wp) ? lo : wp;
+        }
+        return batch->size[0] + batch->size[1];
+}
+
+/**
+ * @brief 原地取出批次中接下来的 size 字节, 记录不会跨越区域
+ *
+ * @param mpsc
+ * @param batch
+ * @param size
+ * @return 数据起始地址, 批次已读完返回 NULL
+ */
+HAPI void *
+mpsc_batch_next(mpsc_t *mpsc, mpsc_batch_t *batch, usz size)
+{
+        if (batch->seg == 0 && batch->pos + size > batch->size[0] && batch->size[1] > 0) {
+                batch->seg = 1;
+                batch->pos = 0;
+        }
+        if (batch->seg > 1 || batch->pos + size > batch->size[batch->seg])
+                return NULL;
+
+        void *ptr   = (u8 *)mpsc->buf + batch->off[batch->seg] + batch->pos;
+        batch->pos += size;
+        return ptr;
+}
+
+/**
+ * @brief 释放批次中已通过 mpsc_batch_next 遍历的部分
+ *
+ * @param mpsc
+ * @param batch
+ */
+HAPI void
+mpsc_release_batch(mpsc_t *mpsc, mpsc_batch_t *batch)
+{
+        if (batch->seg == 0) {
+                mpsc_release(mpsc, batch->pos);
+                return;
+        }
+
+        mpsc->warp_end = MPSC_OFFSET_MAX;
+        ATOMIC_STORE_EXPLICIT(&mpsc->rp, batch->off[1] + batch->pos, memory_order_release);
+}
+
 HAPI isz
 mpsc_write(mpsc_t *mpsc, mpsc_p_t *p, const void *src, usz size)
 {
@@ -1,11 +1,37 @@
 #ifndef SPSC_H
 #define SPSC_H
 
+#include <stdint.h>
 #include <string.h>
 
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "../util/errdef.h"
+#include "../util/macrodef.h"
 #include "../util/mathdef.h"
+#include "../util/timeops.h"
 #include "../util/typedef.h"
 
+#define SPSC_WAIT_FOREVER     (~0ULL) // spsc_wait_avail 无限等待
+#define SPSC_SPIN_MIN         (16)    // 阻塞前自适应自旋次数下限
+#define SPSC_SPIN_MAX         (4096)  // 阻塞前自适应自旋次数上限
+
+#define SPSC_MSG_ALIGN        (8)
+#define SPSC_MSG_ALIGN_UP(sz) (((sz) + (SPSC_MSG_ALIGN - 1)) & ~(usz)(SPSC_MSG_ALIGN - 1))
+#define SPSC_MSG_HDR_SIZE     SPSC_MSG_ALIGN_UP(sizeof(spsc_msg_hdr_t))
+#define SPSC_MSG_PAD          (0xFFFFFFFFU) // 回绕处的填充记录
+
+/*
+ * 定义 SPSC_CACHELINE_ISOLATE 后, 生产者与消费者的索引各占一条缓存行,
+ * 且各自缓存对端索引, 仅在环形缓冲区看起来满/空时才重新加载对端索引,
+ * 避免两个核心在每次读写时争抢同一条缓存行.
+ * 注意: 通过共享内存通信的进程必须使用相同的布局编译.
+ */
+
 /* 写入数据超过剩余空间时的处理策略 */
 typedef enum {
         SPSC_POLICY_TRUNCATE,  // 截断
@@ -17,10 +43,41 @@ typedef struct {
         spsc_policy_e e_policy; // 写入数据超过剩余空间时的处理策略
         void         *buf;      // 缓冲区
         usz           cap;      // 缓冲区容量(2^n)
-        ATOMIC(usz) wp;         // 写入位置
-        ATOMIC(usz) rp;         // 读取位置
+#ifdef SPSC_CACHELINE_ISOLATE
+        CACHELINE_ALIGNED ATOMIC(usz) wp;  // 写入位置
+        usz rp_cache;                      // 生产者缓存的读取位置
+        CACHELINE_ALIGNED ATOMIC(usz) rp;  // 读取位置
+        usz wp_cache;                      // 消费者缓存的写入位置
+        u32 spin_budget;                   // 消费者阻塞前的自适应自旋次数
+        CACHELINE_ALIGNED ATOMIC(u32) seq; // futex 等待字, 生产者唤醒时递增
+        ATOMIC(u32) waiters;               // 阻塞等待中的消费者数量
+#else
+        ATOMIC(usz) wp;      // 写入位置
+        ATOMIC(usz) rp;      // 读取位置
+        u32 spin_budget;     // 消费者阻塞前的自适应自旋次数
+        ATOMIC(u32) seq;     // futex 等待字, 生产者唤醒时递增
+        ATOMIC(u32) waiters; // 阻塞等待中的消费者数量
+#endif
 } spsc_t;
 
+/*
+ * 消息模式下每条记录由 spsc_msg_hdr_t 与按 SPSC_MSG_ALIGN 对齐的负载组成,
+ * 记录在缓冲区内始终连续, 尾部放不下时写入 SPSC_MSG_PAD 填充记录并回绕到起点.
+ * 填充记录与其后的消息一同发布, 两者合计可能接近记录长度的两倍, 因此记录 (头部 + 对齐后的负载)
+ * 不能超过 cap / 2, 这样缓冲区读空后任意位置都能写下一条记录, 不会因回绕永久写不进.
+ * 同一个 spsc_t 不能混用字节流接口与消息接口.
+ */
+typedef struct {
+        u32 size; // 负载长度, SPSC_MSG_PAD 表示填充至缓冲区末尾
+        u32 rsvd; // 保留, 写入时清零
+} spsc_msg_hdr_t;
+
+/* 零拷贝访问时的环形缓冲区片段, 在回绕处最多拆分为两段 */
+typedef struct {
+        u8 *ptr[2];  // 片段起始地址
+        usz size[2]; // 片段长度
+} spsc_span_t;
+
 HAPI int  spsc_init(spsc_t *spsc, void *buf, usz cap, spsc_policy_e e_policy);
 HAPI int  spsc_init_buf(spsc_t *spsc, usz cap, spsc_policy_e e_policy);
 HAPI void spsc_reset(spsc_t *spsc);
@@ -29,12 +86,41 @@ HAPI bool spsc_full(spsc_t *spsc);
 HAPI usz  spsc_avail(spsc_t *spsc);
 HAPI usz  spsc_free(spsc_t *spsc);
 HAPI usz  spsc_policy(spsc_t *spsc, usz wp, usz rp, usz size);
+HAPI usz  spsc_load_rp(spsc_t *spsc, usz wp, usz size);
+HAPI usz  spsc_load_wp(spsc_t *spsc, usz rp, usz size);
+HAPI void spsc_span_init(spsc_t *spsc, void *buf, usz pos, usz size, spsc_span_t *span);
 
 HAPI usz spsc_write(spsc_t *spsc, const void *src, usz size);
 HAPI usz spsc_read(spsc_t *spsc, void *dst, usz size);
 HAPI usz spsc_write_buf(spsc_t *spsc, void *buf, const void *src, usz size);
 HAPI usz spsc_read_buf(spsc_t *spsc, void *buf, void *dst, usz size);
 
+HAPI isz             spsc_msg_write(spsc_t *spsc, const void *src, usz size);
+HAPI isz             spsc_msg_write_buf(spsc_t *spsc, void *buf, const void *src, usz size);
+HAPI usz             spsc_msg_need(spsc_t *spsc, usz wp, usz size);
+HAPI void           *spsc_msg_reserve(spsc_t *spsc, usz size);
+HAPI void           *spsc_msg_reserve_buf(spsc_t *spsc, void *buf, usz size);
+HAPI void            spsc_msg_commit(spsc_t *spsc, usz size);
+HAPI spsc_msg_hdr_t *spsc_msg_head(spsc_t *spsc, void *buf, usz *rp);
+HAPI isz             spsc_msg_peek_len(spsc_t *spsc);
+HAPI isz             spsc_msg_peek_len_buf(spsc_t *spsc, void *buf);
+HAPI isz             spsc_msg_read(spsc_t *spsc, void *dst, usz cap);
+HAPI isz             spsc_msg_read_buf(spsc_t *spsc, void *buf, void *dst, usz cap);
+HAPI void           *spsc_msg_peek(spsc_t *spsc, usz *size);
+HAPI void           *spsc_msg_peek_buf(spsc_t *spsc, void *buf, usz *size);
+HAPI void            spsc_msg_release(spsc_t *spsc);
+HAPI void            spsc_msg_release_buf(spsc_t *spsc, void *buf);
+
+HAPI void spsc_write_wake(spsc_t *spsc);
+HAPI isz  spsc_wait_avail(spsc_t *spsc, usz min_size, u64 timeout_ns);
+
+HAPI usz  spsc_write_reserve(spsc_t *spsc, usz size, spsc_span_t *span);
+HAPI usz  spsc_write_reserve_buf(spsc_t *spsc, void *buf, usz size, spsc_span_t *span);
+HAPI void spsc_write_commit(spsc_t *spsc, usz size);
+HAPI usz  spsc_read_peek(spsc_t *spsc, usz size, spsc_span_t *span);
+HAPI usz  spsc_read_peek_buf(spsc_t *spsc, void *buf, usz size, spsc_span_t *span);
+HAPI void spsc_read_release(spsc_t *spsc, usz size);
+
 /* -------------------------------------------------------------------------- */
 /*                                     API                                    */
 /* -------------------------------------------------------------------------- */
@@ -58,16 +144,24 @@ spsc_init_buf(spsc_t *spsc, const usz cap, const spsc_policy_e e_policy)
 
         spsc->e_policy = e_policy;
         spsc->cap      = cap;
-        ATOMIC_STORE(&spsc->rp, 0);
-        ATOMIC_STORE(&spsc->wp, 0);
+        ATOMIC_STORE(&spsc->seq, 0);
+        ATOMIC_STORE(&spsc->waiters, 0);
+        spsc_reset(spsc);
         return 0;
 }
 
+/* 复位时可能仍有消费者阻塞在 spsc_wait_avail 中, 等待状态 (seq/waiters) 只在初始化时清零 */
+
 HAPI void
 spsc_reset(spsc_t *spsc)
 {
         ATOMIC_STORE(&spsc->rp, 0);
         ATOMIC_STORE(&spsc->wp, 0);
+#ifdef SPSC_CACHELINE_ISOLATE
+        spsc->rp_cache = 0;
+        spsc->wp_cache = 0;
+#endif
+        spsc->spin_budget = SPSC_SPIN_MIN;
 }
 
 HAPI bool
@@ -107,7 +201,12 @@ spsc_policy(spsc_t *spsc, const usz wp, const usz rp, usz size)
                         return size;
                 }
                 case SPSC_POLICY_OVERWRITE: {
-                        atomic_fetch_add_explicit(&spsc->rp, size - free, memory_order_acq_rel);
+                        const usz old = atomic_fetch_add_explicit(&spsc->rp, size - free, memory_order_acq_rel);
+#ifdef SPSC_CACHELINE_ISOLATE
+                        spsc->rp_cache = old + size - free; // 缓存必须随之前移, 否则下次写入以旧位置计算剩余空间
+#else
+                        ARG_UNUSED(old);
+#endif
                         return size;
                 }
                 case SPSC_POLICY_REJECT:
@@ -128,46 +227,670 @@ spsc_read(spsc_t *spsc, void *dst, const usz size)
         return spsc_read_buf(spsc, spsc->buf, dst, size);
 }
 
+/**
+ * @brief 生产者获取读取位置, 缓存的位置不足以容纳 size 字节时才加载对端索引
+ *
+ * @param spsc
+ * @param wp
+ * @param size
+ * @return 读取位置
+ */
 HAPI usz
-spsc_write_buf(spsc_t *spsc, void *buf, const void *src, usz size)
+spsc_load_rp(spsc_t *spsc, const usz wp, const usz size)
 {
-        const usz wp = ATOMIC_LOAD_EXPLICIT(&spsc->wp, memory_order_relaxed);
-        const usz rp = ATOMIC_LOAD_EXPLICIT(&spsc->rp, memory_order_acquire);
+#ifdef SPSC_CACHELINE_ISOLATE
+        // 缓存可能落后于覆盖写入后的读取位置, 已用空间超过容量时视为失效
+        const usz used = wp - spsc->rp_cache;
+        if (used <= spsc->cap && spsc->cap - used >= size)
+                return spsc->rp_cache;
 
-        size = spsc_policy(spsc, wp, rp, size);
-        if (size == 0)
-                return 0;
+        spsc->rp_cache = ATOMIC_LOAD_EXPLICIT(&spsc->rp, memory_order_acquire);
+        return spsc->rp_cache;
+#else
+        ARG_UNUSED(wp);
+        ARG_UNUSED(size);
+        return ATOMIC_LOAD_EXPLICIT(&spsc->rp, memory_order_acquire);
+#endif
+}
+
+/**
+ * @brief 消费者获取写入位置, 缓存的位置不足 size 字节可读时才加载对端索引
+ *
+ * @param spsc
+ * @param rp
+ * @param size
+ * @return 写入位置
+ */
+HAPI usz
+spsc_load_wp(spsc_t *spsc, const usz rp, const usz size)
+{
+#ifdef SPSC_CACHELINE_ISOLATE
+        // 覆盖写入可使读取位置越过缓存的写入位置, 可读数据超过容量时视为失效
+        const usz avail = spsc->wp_cache - rp;
+        if (avail <= spsc->cap && avail >= size)
+                return spsc->wp_cache;
+
+        spsc->wp_cache = ATOMIC_LOAD_EXPLICIT(&spsc->wp, memory_order_acquire);
+        return spsc->wp_cache;
+#else
+        ARG_UNUSED(rp);
+        ARG_UNUSED(size);
+        return ATOMIC_LOAD_EXPLICIT(&spsc->wp, memory_order_acquire);
+#endif
+}
 
+HAPI void
+spsc_span_init(spsc_t *spsc, void *buf, const usz pos, const usz size, spsc_span_t *span)
+{
         const usz mask  = spsc->cap - 1;
-        const usz off   = wp & mask;
+        const usz off   = pos & mask;
         const usz first = MIN(size, spsc->cap - off);
-        memcpy((u8 *)buf + off, src, first);
-        memcpy((u8 *)buf, (u8 *)src + first, size - first);
 
-        ATOMIC_STORE_EXPLICIT(&spsc->wp, wp + size, memory_order_release);
+        span->ptr[0]  = (u8 *)buf + off;
+        span->size[0] = first;
+        span->ptr[1]  = (u8 *)buf;
+        span->size[1] = size - first;
+}
+
+HAPI usz
+spsc_write_buf(spsc_t *spsc, void *buf, const void *src, usz size)
+{
+        spsc_span_t span;
+        size = spsc_write_reserve_buf(spsc, buf, size, &span);
+        if (size == 0)
+                return 0;
+
+        memcpy(span.ptr[0], src, span.size[0]);
+        memcpy(span.ptr[1], (const u8 *)src + span.size[0], span.size[1]);
+
+        spsc_write_commit(spsc, size);
         return size;
 }
 
 HAPI usz
 spsc_read_buf(spsc_t *spsc, void *buf, void *dst, usz size)
+{
+        spsc_span_t span;
+        size = spsc_read_peek_buf(spsc, buf, size, &span);
+        if (size == 0)
+                return 0;
+
+        memcpy(dst, span.ptr[0], span.size[0]);
+        memcpy((u8 *)dst + span.size[0], span.ptr[1], span.size[1]);
+
+        spsc_read_release(spsc, size);
+        return size;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   零拷贝                                   */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief 生产者预留 size 字节的写入空间, 直接在环形缓冲区内序列化数据
+ *
+ * @param spsc
+ * @param size
+ * @param span 输出预留区域的两个片段 (回绕时第二段非空)
+ * @return 实际预留的字节数 (受写入策略影响), 需随后调用 spsc_write_commit 提交
+ */
+HAPI usz
+spsc_write_reserve(spsc_t *spsc, const usz size, spsc_span_t *span)
+{
+        return spsc_write_reserve_buf(spsc, spsc->buf, size, span);
+}
+
+HAPI usz
+spsc_write_reserve_buf(spsc_t *spsc, void *buf, usz size, spsc_span_t *span)
+{
+        const usz wp = ATOMIC_LOAD_EXPLICIT(&spsc->wp, memory_order_relaxed);
+        const usz rp = spsc_load_rp(spsc, wp, size);
+
+        size = spsc_policy(spsc, wp, rp, size);
+        spsc_span_init(spsc, buf, wp, size, span);
+        return size;
+}
+
+/**
+ * @brief 提交已写入的 size 字节, size 不得超过 spsc_write_reserve 的返回值
+ *
+ * @param spsc
+ * @param size
+ */
+HAPI void
+spsc_write_commit(spsc_t *spsc, const usz size)
+{
+        const usz wp = ATOMIC_LOAD_EXPLICIT(&spsc->wp, memory_order_relaxed);
+        ATOMIC_STORE_EXPLICIT(&spsc->wp, wp + size, memory_order_release);
+}
+
+/**
+ * @brief 消费者查看最多 size 字节的可读数据, 不移动读指针
+ *
+ * @param spsc
+ * @param size
+ * @param span 输出可读区域的两个片段 (回绕时第二段非空)
+ * @return 实际可读的字节数, 处理完成后需调用 spsc_read_release 释放
+ */
+HAPI usz
+spsc_read_peek(spsc_t *spsc, const usz size, spsc_span_t *span)
+{
+        return spsc_read_peek_buf(spsc, spsc->buf, size, span);
+}
+
+HAPI usz
+spsc_read_peek_buf(spsc_t *spsc, void *buf, usz size, spsc_span_t *span)
 {
         const usz rp = ATOMIC_LOAD_EXPLICIT(&spsc->rp, memory_order_relaxed);
-        const usz wp = ATOMIC_LOAD_EXPLICIT(&spsc->wp, memory_order_acquire);
+        const usz wp = spsc_load_wp(spsc, rp, size);
 
         const usz avail = wp - rp;
         if (size > avail)
                 size = avail;
-        if (size == 0)
-                return 0;
 
-        const usz mask  = spsc->cap - 1;
-        const usz off   = rp & mask;
-        const usz first = MIN(size, spsc->cap - off);
-        memcpy(dst, (u8 *)buf + off, first);
-        memcpy((u8 *)dst + first, (u8 *)buf, size - first);
+        spsc_span_init(spsc, buf, rp, size, span);
+        return size;
+}
 
+/**
+ * @brief 释放已读取的 size 字节, size 不得超过 spsc_read_peek 的返回值
+ *
+ * @param spsc
+ * @param size
+ */
+HAPI void
+spsc_read_release(spsc_t *spsc, const usz size)
+{
+        const usz rp = ATOMIC_LOAD_EXPLICIT(&spsc->rp, memory_order_relaxed);
         ATOMIC_STORE_EXPLICIT(&spsc->rp, rp + size, memory_order_release);
-        return size;
 }
 
+/* -------------------------------------------------------------------------- */
+/*                                  消息模式                                  */
+/* -------------------------------------------------------------------------- */
+
+HAPI isz
+spsc_msg_write(spsc_t *spsc, const void *src, const usz size)
+{
+        return spsc_msg_write_buf(spsc, spsc->buf, src, size);
+}
+
+/**
+ * @brief 写入一条完整消息, 空间不足时不写入任何数据
+ *
+ * @param spsc
+ * @param buf
+ * @param src
+ * @param size 负载长度
+ * @return 负载长度, 空间暂时不足返回 -MEAGAIN, 记录超过容量的一半返回 -MEINVAL
+ */
+HAPI isz
+spsc_msg_write_buf(spsc_t *spsc, void *buf, const void *src, const usz size)
+{
+        if (SPSC_MSG_HDR_SIZE + SPSC_MSG_ALIGN_UP(size) > spsc->cap / 2 || size >= SPSC_MSG_PAD)
+                return -MEINVAL;
+
+        void *dst = spsc_msg_reserve_buf(spsc, buf, size);
+        if (!dst)
+                return -MEAGAIN;
+
+        memcpy(dst, src, size);
+
+        spsc_msg_commit(spsc, size);
+        return (isz)size;
+}
+
+/**
+ * @brief 计算在写入位置 wp 处写入 size 字节负载实际占用的空间
+ *
+ * @param spsc
+ * @param wp
+ * @param size
+ * @return 占用字节数, 尾部放不下整条记录时包含填充记录
+ */
+HAPI usz
+spsc_msg_need(spsc_t *spsc, const usz wp, const usz size)
+{
+        const usz total = SPSC_MSG_HDR_SIZE + SPSC_MSG_ALIGN_UP(size);
+        const usz tail  = spsc->cap - (wp & (spsc->cap - 1));
+        return (total > tail) ? tail + total : total;
+}
+
+HAPI void *
+spsc_msg_reserve(spsc_t *spsc, const usz size)
+{
+        return spsc_msg_reserve_buf(spsc, spsc->buf, size);
+}
+
+/**
+ * @brief 预留一条 size 字节负载的连续空间, 直接在环形缓冲区内序列化消息
+ *
+ * @param spsc
+ * @param buf
+ * @param size 负载长度
+ * @return 负载起始地址, 空间不足或记录超过容量的一半返回 NULL, 写入完成后需以相同 size 调用 spsc_msg_commit
+ */
+HAPI void *
+spsc_msg_reserve_buf(spsc_t *spsc, void *buf, const usz size)
+{
+        if (SPSC_MSG_HDR_SIZE + SPSC_MSG_ALIGN_UP(size) > spsc->cap / 2 || size >= SPSC_MSG_PAD)
+                return NULL;
+
+        const usz wp   = ATOMIC_LOAD_EXPLICIT(&spsc->wp, memory_order_relaxed);
+        const usz need = spsc_msg_need(spsc, wp, size);
+        const usz rp   = spsc_load_rp(spsc, wp, need);
+        if (need > spsc->cap - (wp - rp))
+                return NULL;
+
+        usz off = wp & (spsc->cap - 1);
+        if (need != SPSC_MSG_HDR_SIZE + SPSC_MSG_ALIGN_UP(size)) {
+                spsc_msg_hdr_t *pad = (spsc_msg_hdr_t *)((u8 *)buf + off);
+                pad->size           = SPSC_MSG_PAD;
+                pad->rsvd           = 0;
+                off                 = 0;
+        }
+
+        spsc_msg_hdr_t *hdr = (spsc_msg_hdr_t *)((u8 *)buf + off);
+        hdr->size           = (u32)size;
+        hdr->rsvd           = 0;
+        return (u8 *)hdr + SPSC_MSG_HDR_SIZE;
+}
+
+/**
+ * @brief 发布 spsc_msg_reserve 预留的消息
+ *
+ * @param spsc
+ * @param size 负载长度, 必须与预留时相同
+ */
+HAPI void
+spsc_msg_commit(spsc_t *spsc, const usz size)
+{
+        const usz wp = ATOMIC_LOAD_EXPLICIT(&spsc->wp, memory_order_relaxed);
+        ATOMIC_STORE_EXPLICIT(&spsc->wp, wp + spsc_msg_need(spsc, wp, size), memory_order_release);
+}
+
+/**
+ * @brief 定位下一条消息的头部, 跳过回绕填充记录
+ *
+ * @param spsc
+ * @param buf
+ * @param rp 输出消息头部所在的读取位置
+ * @return 消息头部, 无消息时返回 NULL
+ */
+HAPI spsc_msg_hdr_t *
+spsc_msg_head(spsc_t *spsc, void *buf, usz *rp)
+{
+        usz       pos = ATOMIC_LOAD_EXPLICIT(&spsc->rp, memory_order_relaxed);
+        const usz wp  = spsc_load_wp(spsc, pos, SPSC_MSG_HDR_SIZE);
+        if (wp - pos < SPSC_MSG_HDR_SIZE)
+                return NULL;
+
+        const usz       off = pos & (spsc->cap - 1);
+        spsc_msg_hdr_t *hdr = (spsc_msg_hdr_t *)((u8 *)buf + off);
+        if (hdr->size == SPSC_MSG_PAD) {
+                // 填充记录与其后的消息一同发布, 此处必然存在下一条消息
+                pos += spsc->cap - off;
+                hdr  = (spsc_msg_hdr_t *)buf;
+        }
+
+        *rp = pos;
+        return hdr;
+}
+
+HAPI isz
+spsc_msg_peek_len(spsc_t *spsc)
+{
+        return spsc_msg_peek_len_buf(spsc, spsc->buf);
+}
+
+/**
+ * @brief 查看下一条消息的负载长度, 不移动读指针
+ *
+ * @param spsc
+ * @param buf
+ * @return 负载长度, 无消息返回 -MEAGAIN
+ */
+HAPI isz
+spsc_msg_peek_len_buf(spsc_t *spsc, void *buf)
+{
+        usz                   rp;
+        const spsc_msg_hdr_t *hdr = spsc_msg_head(spsc, buf, &rp);
+        if (!hdr)
+                return -MEAGAIN;
+
+        return (isz)hdr->size;
+}
+
+HAPI isz
+spsc_msg_read(spsc_t *spsc, void *dst, const usz cap)
+{
+        return spsc_msg_read_buf(spsc, spsc->buf, dst, cap);
+}
+
+/**
+ * @brief 读取一条完整消息, dst 容量不足时不消费该消息
+ *
+ * @param spsc
+ * @param buf
+ * @param dst
+ * @param cap dst 容量
+ * @return 负载长度, 无消息返回 -MEAGAIN, dst 容量不足返回 -MEINVAL
+ */
+HAPI isz
+spsc_msg_read_buf(spsc_t *spsc, void *buf, void *dst, const usz cap)
+{
+        usz         size;
+        const void *src = spsc_msg_peek_buf(spsc, buf, &size);
+        if (!src)
+                return -MEAGAIN;
+
+        if (size > cap)
+                return -MEINVAL;
+
+        memcpy(dst, src, size);
+
+        spsc_msg_release_buf(spsc, buf);
+        return (isz)size;
+}
+
+HAPI void *
+spsc_msg_peek(spsc_t *spsc, usz *size)
+{
+        return spsc_msg_peek_buf(spsc, spsc->buf, size);
+}
+
+/**
+ * @brief 原地查看下一条消息, 不移动读指针
+ *
+ * @param spsc
+ * @param buf
+ * @param size 输出负载长度
+ * @return 负载起始地址, 无消息返回 NULL, 处理完成后需调用 spsc_msg_release 释放
+ */
+HAPI void *
+spsc_msg_peek_buf(spsc_t *spsc, void *buf, usz *size)
+{
+        usz             rp;
+        spsc_msg_hdr_t *hdr = spsc_msg_head(spsc, buf, &rp);
+        if (!hdr)
+                return NULL;
+
+        *size = hdr->size;
+        return (u8 *)hdr + SPSC_MSG_HDR_SIZE;
+}
+
+HAPI void
+spsc_msg_release(spsc_t *spsc)
+{
+        spsc_msg_release_buf(spsc, spsc->buf);
+}
+
+/**
+ * @brief 释放下一条消息 (连同其前方的填充记录)
+ *
+ * @param spsc
+ * @param buf
+ */
+HAPI void
+spsc_msg_release_buf(spsc_t *spsc, void *buf)
+{
+        usz                   rp;
+        const spsc_msg_hdr_t *hdr = spsc_msg_head(spsc, buf, &rp);
+        if (!hdr)
+                return;
+
+        ATOMIC_STORE_EXPLICIT(&spsc->rp, rp + SPSC_MSG_HDR_SIZE + SPSC_MSG_ALIGN_UP(hdr->size), memory_order_release);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  阻塞等待                                  */
+/* -------------------------------------------------------------------------- */
+
+/*
+ * Linux 下使用 futex 等待 spsc_t 内的 seq 字. 未使用 FUTEX_PRIVATE_FLAG,
+ * 因此 spsc_t 位于 shm_open 映射的共享内存中时可以跨进程唤醒.
+ * 其他平台退化为让出 CPU 的轮询.
+ */
+HAPI void
+spsc_futex_wait(ATOMIC(u32) *addr, const u32 val, const u64 timeout_ns)
+{
+#ifdef __linux__
+        if (timeout_ns == SPSC_WAIT_FOREVER) {
+                syscall(SYS_futex, (u32 *)addr, FUTEX_WAIT, val, NULL, NULL, 0);
+                return;
+        }
+
+        const struct timespec ts = {
+            .tv_sec  = (time_t)(timeout_ns / NANO_PER_SEC),
+            .tv_nsec = (long)(timeout_ns % NANO_PER_SEC),
+        };
+        syscall(SYS_futex, (u32 *)addr, FUTEX_WAIT, val, &ts, NULL, 0);
+#else
+        ARG_UNUSED(addr);
+        ARG_UNUSED(val);
+        ARG_UNUSED(timeout_ns);
+        yield(1);
+#endif
+}
+
+HAPI void
+spsc_futex_wake(ATOMIC(u32) *addr)
+{
+#ifdef __linux__
+        syscall(SYS_futex, (u32 *)addr, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+#else
+        ARG_UNUSED(addr);
+#endif
+}
+
+/**
+ * @brief 生产者提交数据后唤醒阻塞在 spsc_wait_avail 上的消费者
+ *
+ * 无等待者时只有一次内存屏障与一次读取, 不进入内核.
+ *
+ * @param spsc
+ */
+HAPI void
+spsc_write_wake(spsc_t *spsc)
+{
+        // 与消费者的 waiters 自增构成 Dekker 式配对: 要么此处看到等待者, 要么消费者看到新的 wp
+        ATOMIC_THREAD_FENCE(memory_order_seq_cst);
+        if (ATOMIC_LOAD_EXPLICIT(&spsc->waiters, memory_order_relaxed) == 0)
+                return;
+
+        ATOMIC_FETCH_ADD_EXPLICIT(&spsc->seq, 1, memory_order_release);
+        spsc_futex_wake(&spsc->seq);
+}
+
+/**
+ * @brief 消费者等待至少 min_size 字节可读
+ *
+ * 先自旋 spin_budget 次, 自旋期间等到数据则加倍预算, 否则减半, 然后进入 futex 睡眠.
+ *
+ * @param spsc
+ * @param min_size 期望的最少可读字节数, 不能超过容量
+ * @param timeout_ns 超时时间, SPSC_WAIT_FOREVER 表示无限等待, 0 表示只检查一次
+ * @return 可读字节数, 超时返回 -METIMEOUT, min_size 超过容量返回 -MEINVAL
+ */
+HAPI isz
+spsc_wait_avail(spsc_t *spsc, const usz min_size, const u64 timeout_ns)
+{
+        if (min_size > spsc->cap)
+                return -MEINVAL;
+
+        usz avail = spsc_avail(spsc);
+        if (avail >= min_size)
+                return (isz)avail;
+        if (timeout_ns == 0)
+                return -METIMEOUT;
+
+        const u64 begin_ns = get_mono_ts_ns();
+
+        // 自旋阶段
+        for (u32 i = 0; i < spsc->spin_budget; i++) {
+                SPINLOCK_BACKOFF_HOOK;
+                avail = spsc_avail(spsc);
+                if (avail >= min_size) {
+                        spsc->spin_budget = MIN(spsc->spin_budget << 1, SPSC_SPIN_MAX);
+                        return (isz)avail;
+                }
+        }
+        spsc->spin_budget = MAX(spsc->spin_budget >> 1, SPSC_SPIN_MIN);
+
+        // 睡眠阶段
+        ATOMIC_FETCH_ADD_EXPLICIT(&spsc->waiters, 1, memory_order_seq_cst);
+        isz ret;
+        for (;;) {
+                const u32 seq = ATOMIC_LOAD_EXPLICIT(&spsc->seq, memory_order_acquire);
+
+                avail = spsc_avail(spsc);
+                if (avail >= min_size) {
+                        ret = (isz)avail;
+                        break;
+                }
+
+                u64 remain_ns = SPSC_WAIT_FOREVER;
+                if (timeout_ns != SPSC_WAIT_FOREVER) {
+                        const u64 elapsed_ns = get_mono_ts_ns() - begin_ns;
+                        if (elapsed_ns >= timeout_ns) {
+                                ret = -METIMEOUT;
+                                break;
+                        }
+                        remain_ns = timeout_ns - elapsed_ns;
+                }
+
+                spsc_futex_wait(&spsc->seq, seq, remain_ns);
+        }
+        ATOMIC_FETCH_SUB_EXPLICIT(&spsc->waiters, 1, memory_order_relaxed);
+        return ret;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  定长元素                                  */
+/* -------------------------------------------------------------------------- */
+
+/*
+ * SPSC_DEFINE(name, type) 生成按元素类型寻址的环形缓冲区 name##_t 及其操作函数,
+ * 元素大小在编译期确定, 单元素读写为一次下标访问, 不经过字节流的写入策略与 memcpy.
+ * 容量以元素个数计且必须为 2^n, 写满时 push 返回 false (等价于 SPSC_POLICY_REJECT).
+ */
+#define SPSC_DEFINE(name, type)                                                       \
+        typedef struct {                                                              \
+                type *buf;      /* 元素缓冲区 */                                           \
+                usz   cap;      /* 元素容量(2^n) */                                       \
+                ATOMIC(usz) wp; /* 写入元素位置 */                                          \
+                ATOMIC(usz) rp; /* 读取元素位置 */                                          \
+        } name##_t;                                                                   \
+                                                                                      \
+        HAPI int name##_init(name##_t *ring, type *buf, const usz cap)                \
+        {                                                                             \
+                if (!IS_POWER_OF_2(cap))                                              \
+                        return -1;                                                    \
+                                                                                      \
+                ring->buf = buf;                                                      \
+                ring->cap = cap;                                                      \
+                ATOMIC_STORE(&ring->rp, 0);                                           \
+                ATOMIC_STORE(&ring->wp, 0);                                           \
+                return 0;                                                             \
+        }                                                                             \
+                                                                                      \
+        HAPI void name##_reset(name##_t *ring)                                        \
+        {                                                                             \
+                ATOMIC_STORE(&ring->rp, 0);                                           \
+                ATOMIC_STORE(&ring->wp, 0);                                           \
+        }                                                                             \
+                                                                                      \
+        HAPI usz name##_avail(name##_t *ring)                                         \
+        {                                                                             \
+                return ATOMIC_LOAD(&ring->wp) - ATOMIC_LOAD(&ring->rp);               \
+        }                                                                             \
+                                                                                      \
+        HAPI usz name##_free(name##_t *ring)                                          \
+        {                                                                             \
+                return ring->cap - name##_avail(ring);                                \
+        }                                                                             \
+                                                                                      \
+        HAPI bool name##_empty(name##_t *ring)                                        \
+        {                                                                             \
+                return name##_avail(ring) == 0;                                       \
+        }                                                                             \
+                                                                                      \
+        HAPI bool name##_full(name##_t *ring)                                         \
+        {                                                                             \
+                return name##_avail(ring) == ring->cap;                               \
+        }                                                                             \
+                                                                                      \
+        HAPI bool name##_push(name##_t *ring, const type val)                         \
+        {                                                                             \
+                const usz wp = ATOMIC_LOAD_EXPLICIT(&ring->wp, memory_order_relaxed); \
+                const usz rp = ATOMIC_LOAD_EXPLICIT(&ring->rp, memory_order_acquire); \
+                if (wp - rp == ring->cap)                                             \
+                        return false;                                                 \
+                                                                                      \
+                ring->buf[wp & (ring->cap - 1)] = val;                                \
+                ATOMIC_STORE_EXPLICIT(&ring->wp, wp + 1, memory_order_release);       \
+                return true;                                                          \
+        }                                                                             \
+                                                                                      \
+        HAPI bool name##_peek(name##_t *ring, type *val)                              \
+        {                                                                             \
+                const usz rp = ATOMIC_LOAD_EXPLICIT(&ring->rp, memory_order_relaxed); \
+                const usz wp = ATOMIC_LOAD_EXPLICIT(&ring->wp, memory_order_acquire); \
+                if (wp == rp)                                                         \
+                        return false;                                                 \
+                                                                                      \
+                *val = ring->buf[rp & (ring->cap - 1)];                               \
+                return true;                                                          \
+        }                                                                             \
+                                                                                      \
+        HAPI bool name##_pop(name##_t *ring, type *val)                               \
+        {                                                                             \
+                const usz rp = ATOMIC_LOAD_EXPLICIT(&ring->rp, memory_order_relaxed); \
+                const usz wp = ATOMIC_LOAD_EXPLICIT(&ring->wp, memory_order_acquire); \
+                if (wp == rp)                                                         \
+                        return false;                                                 \
+                                                                                      \
+                *val = ring->buf[rp & (ring->cap - 1)];                               \
+                ATOMIC_STORE_EXPLICIT(&ring->rp, rp + 1, memory_order_release);       \
+                return true;                                                          \
+        }                                                                             \
+                                                                                      \
+        HAPI usz name##_push_n(name##_t *ring, const type *src, usz n)                \
+        {                                                                             \
+                const usz wp = ATOMIC_LOAD_EXPLICIT(&ring->wp, memory_order_relaxed); \
+                const usz rp = ATOMIC_LOAD_EXPLICIT(&ring->rp, memory_order_acquire); \
+                                                                                      \
+                n = MIN(n, ring->cap - (wp - rp));                                    \
+                if (n == 0)                                                           \
+                        return 0;                                                     \
+                                                                                      \
+                const usz off   = wp & (ring->cap - 1);                               \
+                const usz first = MIN(n, ring->cap - off);                            \
+                memcpy(&ring->buf[off], src, first * sizeof(type));                   \
+                memcpy(ring->buf, &src[first], (n - first) * sizeof(type));           \
+                                                                                      \
+                ATOMIC_STORE_EXPLICIT(&ring->wp, wp + n, memory_order_release);       \
+                return n;                                                             \
+        }                                                                             \
+                                                                                      \
+        HAPI usz name##_pop_n(name##_t *ring, type *dst, usz n)                       \
+        {                                                                             \
+                const usz rp = ATOMIC_LOAD_EXPLICIT(&ring->rp, memory_order_relaxed); \
+                const usz wp = ATOMIC_LOAD_EXPLICIT(&ring->wp, memory_order_acquire); \
+                                                                                      \
+                n = MIN(n, wp - rp);                                                  \
+                if (n == 0)                                                           \
+                        return 0;                                                     \
+                                                                                      \
+                const usz off   = rp & (ring->cap - 1);                               \
+                const usz first = MIN(n, ring->cap - off);                            \
+                memcpy(dst, &ring->buf[off], first * sizeof(type));                   \
+                memcpy(&dst[first], ring->buf, (n - first) * sizeof(type));           \
+                                                                                      \
+                ATOMIC_STORE_EXPLICIT(&ring->rp, rp + n, memory_order_release);       \
+                return n;                                                             \
+        }
+
+SPSC_DEFINE(spsc_f32, f32)
+
 #endif // !SPSC_H
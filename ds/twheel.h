@@ -0,0 +1,256 @@
+#ifndef TWHEEL_H
+#define TWHEEL_H
+
+#include <stdint.h>
+
+#include "../ds/list.h"
+#include "../util/bitops.h"
+#include "../util/macrodef.h"
+#include "../util/mathdef.h"
+#include "../util/typedef.h"
+
+/*
+ * 分层时间轮: 每层 2^TWHEEL_SLOT_BITS 个槽, 第 L 层每槽跨度 2^(L * TWHEEL_SLOT_BITS) tick.
+ * 节点按到期时间与当前时间的差值选择层, 上层槽在下层转完一圈时下放 (cascade).
+ * 插入删除 O(1), 推进时借助每层占用位图跳过空槽, 均摊 O(1).
+ */
+#define TWHEEL_SLOT_BITS (6)
+#define TWHEEL_SLOTS     (1 << TWHEEL_SLOT_BITS)
+#define TWHEEL_MASK      (TWHEEL_SLOTS - 1)
+#define TWHEEL_LEVELS    (4) // 覆盖 2^24 tick, 更远的节点暂存在最高层, 下放时重新定位
+
+typedef struct {
+        list_head_t node;   // 槽内链表节点
+        u64         expire; // 到期 tick
+        u8          level;  // 所在层, TWHEEL_LEVELS 表示不在时间轮中
+        u8          slot;   // 所在槽
+} twheel_node_t;
+
+typedef struct {
+        u64         now;                                // 下一个待处理的 tick
+        u64         map[TWHEEL_LEVELS];                 // 各层槽占用位图
+        list_head_t slots[TWHEEL_LEVELS][TWHEEL_SLOTS]; // 各层槽
+        list_head_t due;                                // 插入时已过期, 下一次推进时输出
+} twheel_t;
+
+/* -------------------------------------------------------------------------- */
+/*                                   声明                                     */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief 初始化时间轮
+ *
+ * @param tw
+ * @param now 起始 tick
+ */
+HAPI void twheel_init(twheel_t *tw, u64 now);
+
+/**
+ * @brief 初始化节点, 使其处于不在时间轮中的状态
+ *
+ * @param node
+ */
+HAPI void twheel_node_init(twheel_node_t *node);
+
+/**
+ * @brief 插入节点, 已过期的节点在下一次推进时输出
+ *
+ * @param tw
+ * @param node
+ * @param expire 到期 tick
+ */
+HAPI void twheel_add(twheel_t *tw, twheel_node_t *node, u64 expire);
+
+/**
+ * @brief 删除节点, 也可用于从 twheel_advance 输出的到期链表中摘除节点
+ *
+ * @param tw
+ * @param node
+ */
+HAPI void twheel_del(twheel_t *tw, twheel_node_t *node);
+
+/**
+ * @brief 推进到 now (包含), 到期节点按到期顺序追加到 expired 尾部
+ *
+ * @param tw
+ * @param now
+ * @param expired
+ */
+HAPI void twheel_advance(twheel_t *tw, u64 now, list_head_t *expired);
+
+/**
+ * @brief 最早到期 tick 的下界, 用于决定可以休眠多久
+ *
+ * 第 0 层给出精确值, 上层给出最近一个非空槽的起始时刻. 推进到该时刻后再次查询即可逼近真实到期时间.
+ *
+ * @param tw
+ * @return 时间轮为空时返回 UINT64_MAX
+ */
+HAPI u64 twheel_next(const twheel_t *tw);
+
+/* -------------------------------------------------------------------------- */
+/*                                   定义                                     */
+/* -------------------------------------------------------------------------- */
+
+HAPI void
+twheel_init(twheel_t *tw, const u64 now)
+{
+        tw->now = now;
+        for (usz l = 0; l < TWHEEL_LEVELS; l++) {
+                tw->map[l] = 0;
+                for (usz s = 0; s < TWHEEL_SLOTS; s++)
+                        list_init(&tw->slots[l][s]);
+        }
+        list_init(&tw->due);
+}
+
+HAPI void
+twheel_node_init(twheel_node_t *node)
+{
+        node->node.prev = NULL;
+        node->node.next = NULL;
+        node->level     = TWHEEL_LEVELS;
+}
+
+HAPI void
+twheel_add(twheel_t *tw, twheel_node_t *node, const u64 expire)
+{
+        node->expire = expire;
+        if (expire < tw->now) {
+                node->level = TWHEEL_LEVELS;
+                list_add_tail(&node->node, &tw->due);
+                return;
+        }
+
+        const u64 delta = expire - tw->now;
+
+        u32 level = delta ? msb64(delta) / TWHEEL_SLOT_BITS : 0;
+        if (level >= TWHEEL_LEVELS)
+                level = TWHEEL_LEVELS - 1;
+
+        const u32 slot = (u32)(expire >> (level * TWHEEL_SLOT_BITS)) & TWHEEL_MASK;
+
+        node->level = (u8)level;
+        node->slot  = (u8)slot;
+        list_add_tail(&node->node, &tw->slots[level][slot]);
+        tw->map[level] |= 1ULL << slot;
+}
+
+HAPI void
+twheel_del(twheel_t *tw, twheel_node_t *node)
+{
+        if (!node->node.next)
+                return;
+
+        list_del(&node->node);
+        if (node->level < TWHEEL_LEVELS && list_empty(&tw->slots[node->level][node->slot]))
+                tw->map[node->level] &= ~(1ULL << node->slot);
+        node->level = TWHEEL_LEVELS;
+}
+
+/* 取下整个槽, 挂到 out 尾部 */
+HAPI void
+twheel_take_slot(twheel_t *tw, const u32 level, const u32 slot, list_head_t *out)
+{
+        list_head_t *head = &tw->slots[level][slot];
+        if (list_empty(head))
+                return;
+
+        list_head_t *first = head->next;
+        list_head_t *last  = head->prev;
+
+        first->prev     = out->prev;
+        out->prev->next = first;
+        last->next      = out;
+        out->prev       = last;
+
+        list_init(head);
+        tw->map[level] &= ~(1ULL << slot);
+}
+
+/* tw->now 位于第 0 层一圈的起点, 逐层下放当前槽 */
+HAPI void
+twheel_cascade(twheel_t *tw)
+{
+        for (u32 level = 1; level < TWHEEL_LEVELS; level++) {
+                const u32 slot = (u32)(tw->now >> (level * TWHEEL_SLOT_BITS)) & TWHEEL_MASK;
+
+                list_head_t pending;
+                list_init(&pending);
+                twheel_take_slot(tw, level, slot, &pending);
+                while (!list_empty(&pending)) {
+                        twheel_node_t *node = CONTAINER_OF(pending.next, twheel_node_t, node);
+                        list_del(&node->node);
+                        twheel_add(tw, node, node->expire);
+                }
+
+                if (slot != 0) // 本层未转完一圈, 更高层无需下放
+                        break;
+        }
+}
+
+HAPI void
+twheel_advance(twheel_t *tw, const u64 now, list_head_t *expired)
+{
+        while (!list_empty(&tw->due))
+                list_move_tail(tw->due.next, expired);
+
+        while (tw->now <= now) {
+                if ((tw->now & TWHEEL_MASK) == 0)
+                        twheel_cascade(tw);
+
+                const u32 idx = (u32)tw->now & TWHEEL_MASK;
+                const u64 occ = tw->map[0] & (~0ULL << idx);
+                if (!occ) {
+                        // 本圈剩余槽为空, 跳到下一圈起点
+                        const u64 next = (tw->now | TWHEEL_MASK) + 1;
+                        if (next > now) {
+                                tw->now = now + 1;
+                                break;
+                        }
+                        tw->now = next;
+                        continue;
+                }
+
+                const u32 slot = lsb64(occ);
+                const u64 tick = (tw->now & ~(u64)TWHEEL_MASK) + slot;
+                if (tick > now) {
+                        tw->now = now + 1;
+                        break;
+                }
+
+                list_head_t *tail = expired->prev;
+                twheel_take_slot(tw, 0, slot, expired);
+                for (list_head_t *pos = tail->next; pos != expired; pos = pos->next) {
+                        twheel_node_t *node = CONTAINER_OF(pos, twheel_node_t, node);
+                        node->level         = TWHEEL_LEVELS;
+                }
+
+                tw->now = tick + 1;
+        }
+}
+
+HAPI u64
+twheel_next(const twheel_t *tw)
+{
+        if (!list_empty(&tw->due))
+                return tw->now;
+
+        u64 next = UINT64_MAX;
+        for (u32 level = 0; level < TWHEEL_LEVELS; level++) {
+                if (!tw->map[level])
+                        continue;
+
+                // tw->now 对齐到本层槽边界时当前槽尚未下放, 属于本圈; 否则当前槽属于下一圈
+                const u32  shift = level * TWHEEL_SLOT_BITS;
+                const u32  idx   = (u32)(tw->now >> shift) & TWHEEL_MASK;
+                const bool curr  = (tw->now & ((1ULL << shift) - 1)) == 0;
+                const u32  from  = curr ? idx : (idx + 1) & TWHEEL_MASK;
+                const u64  occ   = from ? ror64(tw->map[level], from) : tw->map[level];
+                const u64  unit  = (tw->now >> shift) + lsb64(occ) + (curr ? 0 : 1);
+                next             = MIN(next, unit << shift);
+        }
+        return next;
+}
+
+#endif // !TWHEEL_H
@@ -0,0 +1,151 @@
+#ifndef WSDEQUE_H
+#define WSDEQUE_H
+
+#include <stdint.h>
+
+#include "../util/macrodef.h"
+#include "../util/mathdef.h"
+#include "../util/typedef.h"
+
+/*
+ * 有界 Chase-Lev 工作窃取双端队列 (Lê et al., C11 内存模型版本).
+ * 所有者在 bottom 端压入/弹出 (LIFO, 缓存友好), 窃取者在 top 端 CAS 取走最旧的元素.
+ * 只有最后一个元素会在所有者与窃取者之间竞争. 元素为指针, 存储由调用者提供, 容量不可扩展.
+ */
+
+typedef struct {
+        ATOMIC(usz) *buf; // 元素缓冲区, 按 usz 存放指针
+        usz          cap; // 容量(2^n)
+        CACHELINE_ALIGNED ATOMIC(isz) top;    // 窃取端
+        CACHELINE_ALIGNED ATOMIC(isz) bottom; // 所有者端
+} wsdeque_t;
+
+/* -------------------------------------------------------------------------- */
+/*                                   声明                                     */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief 初始化队列
+ *
+ * @param dq
+ * @param buf 至少 cap 个 usz
+ * @param cap 容量(2^n)
+ * @return 0 成功, -1 cap 不是 2^n
+ */
+HAPI int wsdeque_init(wsdeque_t *dq, void *buf, usz cap);
+
+/**
+ * @brief 所有者压入
+ *
+ * @param dq
+ * @param item 非 NULL
+ * @return true
+ * @return false 队列已满
+ */
+HAPI bool wsdeque_push(wsdeque_t *dq, void *item);
+
+/**
+ * @brief 所有者弹出最新压入的元素
+ *
+ * @param dq
+ * @return 队列为空时返回 NULL
+ */
+HAPI void *wsdeque_pop(wsdeque_t *dq);
+
+/**
+ * @brief 窃取最旧的元素, 任意线程可调用
+ *
+ * @param dq
+ * @return 队列为空或竞争失败时返回 NULL
+ */
+HAPI void *wsdeque_steal(wsdeque_t *dq);
+
+/**
+ * @brief 近似元素数量, 仅用于监控
+ *
+ * @param dq
+ * @return usz
+ */
+HAPI usz wsdeque_size(wsdeque_t *dq);
+
+/* -------------------------------------------------------------------------- */
+/*                                   定义                                     */
+/* -------------------------------------------------------------------------- */
+
+HAPI int
+wsdeque_init(wsdeque_t *dq, void *buf, const usz cap)
+{
+        if (!IS_POWER_OF_2(cap))
+                return -1;
+
+        dq->buf = (ATOMIC(usz) *)buf;
+        dq->cap = cap;
+        for (usz i = 0; i < cap; i++)
+                ATOMIC_STORE_EXPLICIT(&dq->buf[i], 0, memory_order_relaxed);
+
+        ATOMIC_STORE_EXPLICIT(&dq->top, 0, memory_order_relaxed);
+        ATOMIC_STORE_EXPLICIT(&dq->bottom, 0, memory_order_release);
+        return 0;
+}
+
+HAPI bool
+wsdeque_push(wsdeque_t *dq, void *item)
+{
+        const isz b = ATOMIC_LOAD_EXPLICIT(&dq->bottom, memory_order_relaxed);
+        const isz t = ATOMIC_LOAD_EXPLICIT(&dq->top, memory_order_acquire);
+        if (b - t >= (isz)dq->cap)
+                return false;
+
+        ATOMIC_STORE_EXPLICIT(&dq->buf[b & (dq->cap - 1)], (usz)(uintptr_t)item, memory_order_relaxed);
+        ATOMIC_STORE_EXPLICIT(&dq->bottom, b + 1, memory_order_release);
+        return true;
+}
+
+HAPI void *
+wsdeque_pop(wsdeque_t *dq)
+{
+        const isz b = ATOMIC_LOAD_EXPLICIT(&dq->bottom, memory_order_relaxed) - 1;
+        ATOMIC_STORE_EXPLICIT(&dq->bottom, b, memory_order_relaxed);
+        ATOMIC_THREAD_FENCE(memory_order_seq_cst);
+        isz t = ATOMIC_LOAD_EXPLICIT(&dq->top, memory_order_relaxed);
+
+        if (t > b) {
+                // 队列为空, 恢复 bottom
+                ATOMIC_STORE_EXPLICIT(&dq->bottom, b + 1, memory_order_relaxed);
+                return NULL;
+        }
+
+        void *item = (void *)(uintptr_t)ATOMIC_LOAD_EXPLICIT(&dq->buf[b & (dq->cap - 1)], memory_order_relaxed);
+        if (t == b) {
+                // 最后一个元素, 与窃取者竞争 top
+                if (!ATOMIC_CAS_STRONG_EXPLICIT(&dq->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+                        item = NULL;
+                ATOMIC_STORE_EXPLICIT(&dq->bottom, b + 1, memory_order_relaxed);
+        }
+        return item;
+}
+
+HAPI void *
+wsdeque_steal(wsdeque_t *dq)
+{
+        isz t = ATOMIC_LOAD_EXPLICIT(&dq->top, memory_order_acquire);
+        ATOMIC_THREAD_FENCE(memory_order_seq_cst);
+        const isz b = ATOMIC_LOAD_EXPLICIT(&dq->bottom, memory_order_acquire);
+        if (t >= b)
+                return NULL;
+
+        void *item = (void *)(uintptr_t)ATOMIC_LOAD_EXPLICIT(&dq->buf[t & (dq->cap - 1)], memory_order_relaxed);
+        if (!ATOMIC_CAS_STRONG_EXPLICIT(&dq->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+                return NULL;
+        return item;
+}
+
+HAPI usz
+wsdeque_size(wsdeque_t *dq)
+{
+        const isz b = ATOMIC_LOAD_EXPLICIT(&dq->bottom, memory_order_relaxed);
+        const isz t = ATOMIC_LOAD_EXPLICIT(&dq->top, memory_order_relaxed);
+        return (b > t) ? (usz)(b - t) : 0;
+}
+
+#endif // !WSDEQUE_H
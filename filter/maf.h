@@ -6,7 +6,7 @@
 
 typedef struct {
         f32 *buf;
-        u32  cap;
+        u32  cap; // 窗口长度(2^n)
 } maf_cfg_t;
 
 typedef struct {
@@ -18,8 +18,8 @@ typedef struct {
 } maf_out_t;
 
 typedef struct {
-        spsc_t spsc;
-        f64    sum;
+        spsc_f32_t ring;
+        f64        sum;
 } maf_lo_t;
 
 typedef struct {
@@ -35,22 +35,24 @@ maf_init(maf_filter_t *maf, const maf_cfg_t maf_cfg)
         DECL_PTRS(maf, cfg, lo);
 
         *cfg = maf_cfg;
-        spsc_init(&lo->spsc, cfg->buf, cfg->cap, SPSC_POLICY_REJECT);
+        spsc_f32_init(&lo->ring, cfg->buf, cfg->cap);
+        lo->sum = 0.0;
 }
 
 HAPI void
 maf_exec(maf_filter_t *maf)
 {
-        DECL_PTRS(maf, cfg, in, lo);
+        DECL_PTRS(maf, in, out, lo);
 
+        // 窗口已满时先移出最旧的样本
         f32 prev_x;
-        spsc_read(&lo->spsc, &prev_x, sizeof(prev_x));
-        lo->sum -= prev_x;
+        if (spsc_f32_full(&lo->ring) && spsc_f32_pop(&lo->ring, &prev_x))
+                lo->sum -= prev_x;
 
-        spsc_write(&lo->spsc, &in->x, sizeof(in->x));
+        spsc_f32_push(&lo->ring, in->x);
 
         lo->sum += in->x;
-        lo->sum /= (f32)cfg->cap;
+        out->y   = (f32)(lo->sum / (f64)spsc_f32_avail(&lo->ring));
 }
 
 HAPI void
@@ -9,7 +9,12 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
 #include "../ds/mpsc.h"
+#include "../ds/spsc.h"
 #include "../util/macrodef.h"
 #include "../util/typedef.h"
 
@@ -26,32 +31,48 @@ typedef enum {
         LOG_MODE_ASYNC,
 } log_mode_e;
 
+typedef enum {
+        LOG_BACKEND_MPSC,  // 所有写线程共享一个 MPSC 环形缓冲区
+        LOG_BACKEND_SHARD, // 每个写线程独占一个 SPSC 分片, 刷新时按时间戳归并
+} log_backend_e;
+
 typedef struct {
         u64 ts;
         usz id;
         usz size;
 } log_entry_t;
 
+typedef struct {
+        CACHELINE_ALIGNED spsc_t spsc; // 分片环形缓冲区 (消息模式)
+        ATOMIC(bool) used;             // 是否已被写线程占用
+        u64 head_ts;                   // 队首记录时间戳 (消费者独占)
+        usz heap;                      // 归并小顶堆的存储槽位 (消费者独占)
+} log_shard_t;
+
 typedef u64 (*log_get_ts_f)(void);
 typedef void (*log_flush_f)(void *fp, const u8 *src, size_t size);
 
 typedef struct {
-        log_mode_e   e_mode;
-        log_level_e  e_level;
-        void        *fp;
-        void        *buf;
-        size_t       cap;
-        u8          *flush_buf;
-        size_t       flush_cap;
-        mpsc_p_t    *producers;
-        size_t       nproducers;
-        log_get_ts_f f_get_ts;
-        log_flush_f  f_flush;
+        log_mode_e    e_mode;
+        log_level_e   e_level;
+        log_backend_e e_backend;
+        void         *fp;
+        void         *buf;
+        size_t        cap;
+        u8           *flush_buf;
+        size_t        flush_cap;
+        mpsc_p_t     *producers;  // LOG_BACKEND_MPSC
+        size_t        nproducers; // LOG_BACKEND_MPSC
+        log_shard_t  *shards;     // LOG_BACKEND_SHARD, buf 按分片数均分
+        size_t        nshards;    // LOG_BACKEND_SHARD
+        log_get_ts_f  f_get_ts;
+        log_flush_f   f_flush;
 } log_cfg_t;
 
 typedef struct {
         mpsc_t mpsc;
         bool   busy;
+        ATOMIC(usz) nshards_used; // 曾被占用过的最大分片编号 + 1, 限定消费者的扫描范围
 } log_lo_t;
 
 typedef struct {
@@ -60,7 +81,16 @@ typedef struct {
 } log_t;
 
 HAPI void log_init(log_t *log, log_cfg_t log_cfg);
+HAPI u8  *log_reserve(log_t *log, usz id, usz size, void **handle);
+HAPI void log_commit(log_t *log, void *handle, usz size);
+HAPI void log_emit(log_t *log, const log_entry_t *entry, const u8 *payload, bool bin);
+
+HAPI log_shard_t *log_shard_get(log_t *log);
+HAPI void         log_shard_unreg(log_t *log);
+HAPI void         log_shard_flush(log_t *log, bool bin);
+
 HAPI void log_write_bin(log_t *log, usz id, const void *data, usz size);
+HAPI void log_flush_batch(log_t *log, bool bin);
 HAPI void log_flush_bin(log_t *log);
 HAPI void log_write(log_t *log, usz id, const char *fmt, va_list args);
 HAPI void log_flush(log_t *log);
@@ -77,14 +107,309 @@ log_init(log_t *log, const log_cfg_t log_cfg)
         DECL_PTRS(log, cfg, lo);
 
         *cfg = log_cfg;
-        mpsc_init(&lo->mpsc, cfg->buf, cfg->cap, cfg->producers, cfg->nproducers);
+
+        switch (cfg->e_backend) {
+                case LOG_BACKEND_MPSC: {
+                        mpsc_init(&lo->mpsc, cfg->buf, cfg->cap, cfg->producers, cfg->nproducers);
+                        break;
+                }
+                case LOG_BACKEND_SHARD: {
+                        // 每个分片取不超过 cap / nshards 的最大 2^n 容量
+                        usz shard_cap = 1;
+                        while (shard_cap << 1 <= cfg->cap / cfg->nshards)
+                                shard_cap <<= 1;
+
+                        for (usz i = 0; i < cfg->nshards; i++) {
+                                log_shard_t *shard = &cfg->shards[i];
+                                spsc_init(&shard->spsc, (u8 *)cfg->buf + i * shard_cap, shard_cap, SPSC_POLICY_REJECT);
+                                ATOMIC_STORE(&shard->used, false);
+                        }
+                        ATOMIC_STORE(&lo->nshards_used, 0);
+                        break;
+                }
+        }
+}
+
+/**
+ * @brief 为一条 size 字节的记录 (含 log_entry_t) 预留连续空间
+ *
+ * @param log
+ * @param id
+ * @param size
+ * @param handle 输出提交时使用的后端句柄
+ * @return 记录起始地址, 空间不足返回 NULL
+ */
+HAPI u8 *
+log_reserve(log_t *log, const usz id, const usz size, void **handle)
+{
+        DECL_PTRS(log, cfg, lo);
+
+        if (size > cfg->cap)
+                return NULL;
+
+        switch (cfg->e_backend) {
+                case LOG_BACKEND_MPSC: {
+                        mpsc_p_t *p   = mpsc_reg(&lo->mpsc, id);
+                        const isz off = mpsc_acquire(&lo->mpsc, p, size);
+                        if (off < 0) {
+                                mpsc_unreg(p);
+                                return NULL;
+                        }
+
+                        *handle = p;
+                        return (u8 *)lo->mpsc.buf + (usz)off;
+                }
+                case LOG_BACKEND_SHARD: {
+                        log_shard_t *shard = log_shard_get(log);
+                        if (!shard)
+                                return NULL;
+
+                        *handle = shard;
+                        return (u8 *)spsc_msg_reserve(&shard->spsc, size);
+                }
+        }
+        return NULL;
 }
 
 HAPI void
-log_write_bin(log_t *log, const usz id, const void *data, const usz size)
+log_commit(log_t *log, void *handle, const usz size)
+{
+        DECL_PTRS(log, cfg);
+
+        switch (cfg->e_backend) {
+                case LOG_BACKEND_MPSC: {
+                        mpsc_push((mpsc_p_t *)handle);
+                        mpsc_unreg((mpsc_p_t *)handle);
+                        break;
+                }
+                case LOG_BACKEND_SHARD: {
+                        spsc_msg_commit(&((log_shard_t *)handle)->spsc, size);
+                        break;
+                }
+        }
+}
+
+/**
+ * @brief 输出一条记录, 文本记录附加 [ts][id] 前缀
+ *
+ * @param log
+ * @param entry
+ * @param payload
+ * @param bin
+ */
+HAPI void
+log_emit(log_t *log, const log_entry_t *entry, const u8 *payload, const bool bin)
+{
+        DECL_PTRS(log, cfg);
+
+        if (bin) {
+                cfg->f_flush(cfg->fp, payload, entry->size);
+                return;
+        }
+
+#ifdef MCU
+        usz total_size = snprintf((char *)cfg->flush_buf, cfg->flush_cap, "[%llu][%u]", entry->ts, entry->id);
+#else
+        usz total_size = snprintf((char *)cfg->flush_buf, cfg->flush_cap, "[%llu][%llu]", entry->ts, entry->id);
+#endif
+        total_size = MIN(total_size, cfg->flush_cap);
+
+        const usz msg_size = MIN(entry->size, cfg->flush_cap - total_size);
+        memcpy(cfg->flush_buf + total_size, payload, msg_size);
+
+        cfg->f_flush(cfg->fp, cfg->flush_buf, total_size + msg_size);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  分片后端                                  */
+/* -------------------------------------------------------------------------- */
+
+#define LOG_TLS_MAX (4) // 每个线程可同时写入的 log_t 数量
+
+typedef struct {
+        log_t       *log;
+        log_shard_t *shard;
+} log_tls_t;
+
+HAPI log_tls_t *
+log_shard_tls(void)
+{
+        static THREAD_LOCAL log_tls_t tls[LOG_TLS_MAX];
+        return tls;
+}
+
+/* 释放线程缓存中属于 log 的分片, log 为 NULL 时释放全部 */
+HAPI void
+log_shard_release(log_tls_t *tls, const log_t *log)
+{
+        for (usz i = 0; i < LOG_TLS_MAX; i++) {
+                if (!tls[i].log || (log && tls[i].log != log))
+                        continue;
+
+                ATOMIC_STORE_EXPLICIT(&tls[i].shard->used, false, memory_order_release);
+                tls[i].log   = NULL;
+                tls[i].shard = NULL;
+        }
+}
+
+/*
+ * 写线程退出时由线程私有数据的析构函数释放其占用的所有分片, 分片可被之后的线程复用.
+ * Windows 下没有该机制, 写线程退出前需调用 log_shard_unreg.
+ */
+#ifndef _WIN32
+static pthread_key_t  log_shard_key;
+static pthread_once_t log_shard_key_once = PTHREAD_ONCE_INIT;
+
+HAPI void
+log_shard_exit(void *arg)
+{
+        log_shard_release((log_tls_t *)arg, NULL);
+}
+
+HAPI void
+log_shard_key_init(void)
+{
+        pthread_key_create(&log_shard_key, log_shard_exit);
+}
+#endif
+
+/**
+ * @brief 获取当前线程在 log 中独占的分片, 首次调用时自动占用编号最小的空闲分片
+ *
+ * @param log
+ * @return 分片, 无空闲分片或当前线程已在 LOG_TLS_MAX 个 log_t 中占用分片时返回 NULL
+ */
+HAPI log_shard_t *
+log_shard_get(log_t *log)
 {
         DECL_PTRS(log, cfg, lo);
 
+        log_tls_t *tls  = log_shard_tls();
+        log_tls_t *slot = NULL;
+        for (usz i = 0; i < LOG_TLS_MAX; i++) {
+                if (tls[i].log == log)
+                        return tls[i].shard;
+                if (!tls[i].log && !slot)
+                        slot = &tls[i];
+        }
+
+        // 线程缓存已满, 不能让出其它 log_t 的分片
+        if (!slot)
+                return NULL;
+
+        for (usz i = 0; i < cfg->nshards; i++) {
+                log_shard_t *shard    = &cfg->shards[i];
+                bool         expected = false;
+                if (ATOMIC_LOAD_EXPLICIT(&shard->used, memory_order_relaxed))
+                        continue;
+                if (!ATOMIC_CAS_STRONG_EXPLICIT(&shard->used, &expected, true, memory_order_acquire, memory_order_relaxed))
+                        continue;
+
+                usz nused = ATOMIC_LOAD_EXPLICIT(&lo->nshards_used, memory_order_relaxed);
+                while (nused < i + 1 &&
+                       !ATOMIC_CAS_WEAK_EXPLICIT(&lo->nshards_used, &nused, i + 1, memory_order_release, memory_order_relaxed))
+                        ;
+
+                slot->log   = log;
+                slot->shard = shard;
+#ifndef _WIN32
+                // 析构函数只在值非 NULL 时调用
+                pthread_once(&log_shard_key_once, log_shard_key_init);
+                pthread_setspecific(log_shard_key, tls);
+#endif
+                return shard;
+        }
+        return NULL;
+}
+
+/**
+ * @brief 释放当前线程占用的分片; 线程退出时自动释放 (Windows 除外), 未刷新的记录仍会被消费者读出
+ *
+ * @param log
+ */
+HAPI void
+log_shard_unreg(log_t *log)
+{
+        log_shard_release(log_shard_tls(), log);
+}
+
+HAPI bool
+log_shard_head(log_shard_t *shard)
+{
+        usz                size;
+        const log_entry_t *entry = (const log_entry_t *)spsc_msg_peek(&shard->spsc, &size);
+        if (!entry)
+                return false;
+
+        shard->head_ts = entry->ts;
+        return true;
+}
+
+/* 小顶堆以 shards[k].heap 存放堆中第 k 个位置对应的分片编号 */
+HAPI void
+log_shard_sift_down(log_shard_t *shards, const usz n, usz i)
+{
+        for (;;) {
+                const usz l   = 2 * i + 1;
+                const usz r   = l + 1;
+                usz       min = i;
+                if (l < n && shards[shards[l].heap].head_ts < shards[shards[min].heap].head_ts)
+                        min = l;
+                if (r < n && shards[shards[r].heap].head_ts < shards[shards[min].heap].head_ts)
+                        min = r;
+                if (min == i)
+                        return;
+
+                const usz tmp    = shards[i].heap;
+                shards[i].heap   = shards[min].heap;
+                shards[min].heap = tmp;
+                i                = min;
+        }
+}
+
+/**
+ * @brief 按时间戳对所有非空分片做 k 路归并并输出
+ *
+ * @param log
+ * @param bin 是否按二进制输出
+ */
+HAPI void
+log_shard_flush(log_t *log, const bool bin)
+{
+        DECL_PTRS(log, cfg, lo);
+
+        log_shard_t *shards = cfg->shards;
+        const usz    nused  = ATOMIC_LOAD_EXPLICIT(&lo->nshards_used, memory_order_acquire);
+
+        usz n = 0;
+        for (usz i = 0; i < nused; i++) {
+                if (log_shard_head(&shards[i]))
+                        shards[n++].heap = i;
+        }
+        for (usz i = n / 2; i-- > 0;)
+                log_shard_sift_down(shards, n, i);
+
+        while (n > 0 && !lo->busy) {
+                log_shard_t       *shard = &shards[shards[0].heap];
+                usz                size;
+                const log_entry_t *entry = (const log_entry_t *)spsc_msg_peek(&shard->spsc, &size);
+
+                log_emit(log, entry, (const u8 *)entry + sizeof(*entry), bin);
+                spsc_msg_release(&shard->spsc);
+
+                if (!log_shard_head(shard))
+                        shards[0].heap = shards[--n].heap;
+                log_shard_sift_down(shards, n, 0);
+
+                lo->busy = (cfg->e_mode == LOG_MODE_ASYNC);
+        }
+}
+
+HAPI void
+log_write_bin(log_t *log, const usz id, const void *data, const usz size)
+{
+        DECL_PTRS(log, cfg);
+
         const log_entry_t entry = {
             .ts   = cfg->f_get_ts(),
             .id   = id,
@@ -92,46 +417,58 @@ log_write_bin(log_t *log, const usz id, const void *data, const usz size)
         };
 
         const usz total_size = sizeof(entry) + entry.size;
-        if (total_size > cfg->cap)
-                return;
 
-        mpsc_p_t *p   = mpsc_reg(&lo->mpsc, id);
-        const isz off = mpsc_acquire(&lo->mpsc, p, total_size);
-        if (off < 0) {
-                mpsc_unreg(p);
+        void *handle;
+        u8   *buf = log_reserve(log, id, total_size, &handle);
+        if (!buf)
                 return;
-        }
 
-        u8 *buf = (u8 *)lo->mpsc.buf + (usz)off;
         memcpy(buf, &entry, sizeof(entry));
-        memcpy((u8 *)buf + sizeof(entry), data, size);
+        memcpy(buf + sizeof(entry), data, size);
 
-        mpsc_push(p);
-        mpsc_unreg(p);
+        log_commit(log, handle, total_size);
 }
 
+/**
+ * @brief 批量取出 MPSC 中已提交的记录并原地遍历, 每批只扫描一次生产者并释放一次
+ *
+ * @param log
+ * @param bin 是否按二进制输出
+ */
 HAPI void
-log_flush_bin(log_t *log)
+log_flush_batch(log_t *log, const bool bin)
 {
         DECL_PTRS(log, cfg, lo);
 
-        while (!lo->busy) {
-                log_entry_t entry      = {0};
-                const usz   entry_size = mpsc_read(&lo->mpsc, &entry, sizeof(entry));
-                if (entry_size == 0)
-                        break;
+        mpsc_batch_t batch;
+        while (!lo->busy && mpsc_pop_batch(&lo->mpsc, &batch) > 0) {
+                const log_entry_t *entry;
+                while (!lo->busy && (entry = (const log_entry_t *)mpsc_batch_next(&lo->mpsc, &batch, sizeof(*entry)))) {
+                        const u8 *payload = (const u8 *)mpsc_batch_next(&lo->mpsc, &batch, entry->size);
+                        log_emit(log, entry, payload, bin);
+                        lo->busy = (cfg->e_mode == LOG_MODE_ASYNC);
+                }
+                mpsc_release_batch(&lo->mpsc, &batch);
+        }
+}
 
-                usz total_size = mpsc_read(&lo->mpsc, cfg->flush_buf, entry.size);
+HAPI void
+log_flush_bin(log_t *log)
+{
+        DECL_PTRS(log, cfg);
 
-                cfg->f_flush(cfg->fp, cfg->flush_buf, total_size);
-                lo->busy = (cfg->e_mode == LOG_MODE_ASYNC);
+        if (cfg->e_backend == LOG_BACKEND_SHARD) {
+                log_shard_flush(log, true);
+                return;
         }
+
+        log_flush_batch(log, true);
 }
 
 HAPI void
 log_write(log_t *log, const usz id, const char *fmt, va_list args)
 {
-        DECL_PTRS(log, cfg, lo);
+        DECL_PTRS(log, cfg);
 
         va_list args_entry;
         va_copy(args_entry, args);
@@ -143,17 +480,12 @@ log_write(log_t *log, const usz id, const char *fmt, va_list args)
         va_end(args_entry);
 
         const usz total_size = sizeof(entry) + entry.size;
-        if (total_size > cfg->cap)
-                return;
 
-        mpsc_p_t *p   = mpsc_reg(&lo->mpsc, id);
-        const isz off = mpsc_acquire(&lo->mpsc, p, total_size);
-        if (off < 0) {
-                mpsc_unreg(p);
+        void *handle;
+        u8   *buf = log_reserve(log, id, total_size, &handle);
+        if (!buf)
                 return;
-        }
 
-        u8 *buf = (u8 *)lo->mpsc.buf + (usz)off;
         memcpy(buf, &entry, sizeof(entry));
 
         va_list args_msg;
@@ -161,8 +493,7 @@ log_write(log_t *log, const usz id, const char *fmt, va_list args)
         const int msg_size = vsnprintf((char *)buf + sizeof(entry), entry.size, fmt, args_msg);
         va_end(args_msg);
 
-        mpsc_push(p);
-        mpsc_unreg(p);
+        log_commit(log, handle, total_size);
 
         if (msg_size != (int)entry.size)
                 return;
@@ -171,25 +502,14 @@ log_write(log_t *log, const usz id, const char *fmt, va_list args)
 HAPI void
 log_flush(log_t *log)
 {
-        DECL_PTRS(log, cfg, lo);
-
-        while (!lo->busy) {
-                log_entry_t entry      = {0};
-                const usz   entry_size = mpsc_read(&lo->mpsc, &entry, sizeof(entry));
-                if (entry_size == 0)
-                        break;
-
-#ifdef MCU
-                usz total_size = snprintf((char *)cfg->flush_buf, cfg->flush_cap, "[%llu][%u]", entry.ts, entry.id);
-#else
-                usz total_size = snprintf((char *)cfg->flush_buf, cfg->flush_cap, "[%llu][%llu]", entry.ts, entry.id);
-#endif
-
-                total_size += mpsc_read(&lo->mpsc, cfg->flush_buf + total_size, entry.size);
+        DECL_PTRS(log, cfg);
 
-                cfg->f_flush(cfg->fp, cfg->flush_buf, total_size);
-                lo->busy = (cfg->e_mode == LOG_MODE_ASYNC);
+        if (cfg->e_backend == LOG_BACKEND_SHARD) {
+                log_shard_flush(log, false);
+                return;
         }
+
+        log_flush_batch(log, false);
 }
 
 HAPI void
@@ -0,0 +1,246 @@
+#ifndef SCHED_CORO_H
+#define SCHED_CORO_H
+
+#include "../ds/spsc.h"
+#include "../util/errdef.h"
+#include "../util/macrodef.h"
+#include "../util/typedef.h"
+
+#include "sched.h"
+
+/*
+ * 无栈协程任务: 协程是一个周期任务, 回调可以在等待处返回, 在之后的 sched_exec 中从等待处继续.
+ * 恢复点记录在 sched_coro_t 中, 以 switch/case 跳转 (protothread), 不需要独立的栈, 可在 C 中使用.
+ *
+ * 限制:
+ *  - 局部变量在等待后不保留, 需要跨等待的状态放在包含 sched_coro_t 的结构中;
+ *  - 协程函数中跨等待的代码不能再使用 switch, 同一行不能有两个等待.
+ *
+ * 等待方式:
+ *  - SCHED_CORO_YIELD: 让出, 在下一次周期释放时继续;
+ *  - SCHED_CORO_SLEEP: 任务休眠 tick 后继续;
+ *  - SCHED_CORO_AWAIT: 任务休眠到 sched_coro_wake 或超时, 网络请求以 sched_coro_net_cb 作为回调时即等待网络完成;
+ *  - SCHED_CORO_AWAIT_UNTIL / SCHED_CORO_AWAIT_SPSC: 每次周期释放时检查条件, 条件满足或超时后继续.
+ */
+
+typedef enum {
+        SCHED_CORO_RET_YIELD, // 等待下一次周期释放
+        SCHED_CORO_RET_WAIT,  // 休眠到 lo.wake_ts 或被唤醒
+        SCHED_CORO_RET_DONE,  // 结束, 移除任务
+} sched_coro_ret_e;
+
+struct sched_coro;
+typedef sched_coro_ret_e (*sched_coro_f)(struct sched_coro *co);
+
+typedef struct {
+        usz          id;        // 任务 ID
+        u32          priority;  // 任务优先级
+        usz          exec_freq; // 周期释放频率, 决定 SCHED_CORO_YIELD 与条件等待的检查间隔
+        sched_coro_f f_cb;      // 协程函数, 以 SCHED_CORO_BEGIN / SCHED_CORO_END 包围
+        void        *arg;       // 协程参数
+} sched_coro_cfg_t;
+
+typedef struct {
+        sched_t      *sched;
+        sched_task_t *task;     // 对应的任务, 结束后为 NULL
+        u32           line;     // 恢复点, 0 表示从头执行
+        usz           wake_ts;  // SCHED_CORO_RET_WAIT 的超时时刻
+        usz           deadline; // 当前等待的超时时刻, SCHED_WAKE_NEVER 不超时
+        bool          waiting;  // 正在等待 sched_coro_wake
+        bool          ready;    // 当前等待的事件已发生
+        bool          timeout;  // 最近一次等待因超时结束
+        int           res;      // 最近一次 sched_coro_wake 的结果, 网络完成时为 cqe->res
+} sched_coro_lo_t;
+
+typedef struct sched_coro {
+        sched_coro_cfg_t cfg;
+        sched_coro_lo_t  lo;
+} sched_coro_t;
+
+/* 协程函数体的开始与结束 */
+#define SCHED_CORO_BEGIN(co)     \
+        switch ((co)->lo.line) { \
+                case 0:
+
+#define SCHED_CORO_END(co)         \
+        }                          \
+        return SCHED_CORO_RET_DONE
+
+/* 记录恢复点, 首次经过时不进入 if, 恢复时跳入 if 内继续执行 */
+#define SCHED_CORO_LABEL(co)      \
+        (co)->lo.line = __LINE__; \
+        if (0) {                  \
+                case __LINE__:;   \
+        }
+
+/* 让出, 在下一次周期释放时继续 */
+#define SCHED_CORO_YIELD(co)                 \
+        do {                                 \
+                (co)->lo.line = __LINE__;    \
+                return SCHED_CORO_RET_YIELD; \
+                case __LINE__:;              \
+        } while (0)
+
+/* 休眠 tick 后继续 */
+#define SCHED_CORO_SLEEP(co, tick)                                          \
+        do {                                                                \
+                (co)->lo.wake_ts = (usz)sched_now((co)->lo.sched) + (tick); \
+                (co)->lo.line    = __LINE__;                                \
+                return SCHED_CORO_RET_WAIT;                                 \
+                case __LINE__:;                                             \
+        } while (0)
+
+/* 等待 sched_coro_wake, 超时 timeout_tick (SCHED_WAKE_NEVER 不超时), 结束后 lo.timeout / lo.res 为结果 */
+#define SCHED_CORO_AWAIT(co, timeout_tick)                     \
+        do {                                                   \
+                sched_coro_wait_begin(co, timeout_tick, true); \
+                SCHED_CORO_LABEL(co)                           \
+                if (!sched_coro_wait_done(co))                 \
+                        return SCHED_CORO_RET_WAIT;            \
+        } while (0)
+
+/* 等待 cond 成立, 每次周期释放时检查, 超时 timeout_tick, 结束后 lo.timeout 为结果 */
+#define SCHED_CORO_AWAIT_UNTIL(co, cond, timeout_tick)          \
+        do {                                                    \
+                sched_coro_wait_begin(co, timeout_tick, false); \
+                SCHED_CORO_LABEL(co)                            \
+                if (!sched_coro_poll_done(co, (cond)))          \
+                        return SCHED_CORO_RET_YIELD;            \
+        } while (0)
+
+/* 等待 SPSC 环形缓冲区非空 */
+#define SCHED_CORO_AWAIT_SPSC(co, spsc, timeout_tick) SCHED_CORO_AWAIT_UNTIL(co, !spsc_empty(spsc), timeout_tick)
+
+/* -------------------------------------------------------------------------- */
+/*                                   声明                                     */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief 创建协程并作为任务加入调度器. 调用限制同 sched_add_task
+ *
+ * @param sched
+ * @param co
+ * @param co_cfg
+ * @return 同 sched_add_task
+ */
+HAPI int sched_coro_spawn(sched_t *sched, sched_coro_t *co, sched_coro_cfg_t co_cfg);
+
+/**
+ * @brief 唤醒等待中的协程, 在下一轮 sched_exec 继续. 只能在调度线程中调用
+ *
+ * 协程不在 SCHED_CORO_AWAIT 中时只记录结果, 不唤醒.
+ *
+ * @param co
+ * @param res 结果, 协程中由 lo.res 读取
+ * @return 0 成功, -MEINVAL 协程已结束
+ */
+HAPI int sched_coro_wake(sched_coro_t *co, int res);
+
+/* -------------------------------------------------------------------------- */
+/*                                   定义                                     */
+/* -------------------------------------------------------------------------- */
+
+HAPI void
+sched_coro_wait_begin(sched_coro_t *co, const usz timeout_tick, const bool waiting)
+{
+        DECL_PTRS(co, lo);
+
+        const usz now = (usz)sched_now(lo->sched);
+        lo->deadline  = (timeout_tick == SCHED_WAKE_NEVER) ? SCHED_WAKE_NEVER : now + timeout_tick;
+        lo->waiting   = waiting;
+        lo->ready     = false;
+        lo->timeout   = false;
+}
+
+/* 事件已发生或已超时时结束等待, 否则设置休眠的超时时刻 */
+HAPI bool
+sched_coro_wait_done(sched_coro_t *co)
+{
+        DECL_PTRS(co, lo);
+
+        if (!lo->ready && (lo->deadline == SCHED_WAKE_NEVER || (usz)sched_now(lo->sched) < lo->deadline)) {
+                lo->wake_ts = lo->deadline;
+                return false;
+        }
+        lo->timeout = !lo->ready;
+        lo->waiting = false;
+        return true;
+}
+
+HAPI bool
+sched_coro_poll_done(sched_coro_t *co, const bool cond)
+{
+        DECL_PTRS(co, lo);
+
+        if (!cond && (lo->deadline == SCHED_WAKE_NEVER || (usz)sched_now(lo->sched) < lo->deadline))
+                return false;
+        lo->timeout = !cond;
+        return true;
+}
+
+/* 任务回调: 执行协程到下一个等待处, 按返回值休眠, 继续周期释放或移除任务 */
+HAPI void
+sched_coro_exec(void *arg)
+{
+        sched_coro_t *co = (sched_coro_t *)arg;
+        DECL_PTRS(co, cfg, lo);
+
+        switch (cfg->f_cb(co)) {
+                case SCHED_CORO_RET_WAIT: {
+                        sched_task_sleep(lo->sched, lo->task, lo->wake_ts);
+                        break;
+                }
+                case SCHED_CORO_RET_DONE: {
+                        sched_remove_task(lo->sched, cfg->id);
+                        lo->task = NULL;
+                        break;
+                }
+                case SCHED_CORO_RET_YIELD:
+                default:
+                        break;
+        }
+}
+
+HAPI int
+sched_coro_spawn(sched_t *sched, sched_coro_t *co, const sched_coro_cfg_t co_cfg)
+{
+        DECL_PTRS(co, cfg, lo);
+
+        if (!co_cfg.f_cb)
+                return -MEINVAL;
+
+        *cfg = co_cfg;
+        memset(lo, 0, sizeof(sched_coro_lo_t));
+        lo->sched = sched;
+
+        const sched_task_cfg_t task_cfg = {
+            .id        = cfg->id,
+            .priority  = cfg->priority,
+            .exec_freq = cfg->exec_freq,
+            .f_cb      = sched_coro_exec,
+            .arg       = co,
+        };
+        const int ret = sched_add_task(sched, task_cfg);
+        if (ret < 0)
+                return ret;
+
+        lo->task = sched_task_find(sched, cfg->id);
+        return 0;
+}
+
+HAPI int
+sched_coro_wake(sched_coro_t *co, const int res)
+{
+        DECL_PTRS(co, lo);
+
+        if (!lo->task)
+                return -MEINVAL;
+
+        lo->res   = res;
+        lo->ready = true;
+        if (lo->waiting)
+                sched_task_wake(lo->sched, lo->task);
+        return 0;
+}
+
+#endif // !SCHED_CORO_H
@@ -0,0 +1,289 @@
+#ifndef SCHED_DAG_H
+#define SCHED_DAG_H
+
+#include "../util/errdef.h"
+#include "../util/macrodef.h"
+#include "../util/timeops.h"
+#include "../util/typedef.h"
+
+#include "group.h"
+#include "stats.h"
+
+/*
+ * 周期内的任务图: 一个控制周期拆分为若干阶段, 阶段在所有前驱完成后就绪.
+ * DAG 本身作为普通周期任务加入调度器 (f_cb = sched_dag_exec, arg = dag), 每次释放完整执行一遍.
+ * 配置了调度组时, 完成的阶段在本线程继续执行第一个就绪的后继, 其余后继提交到调度组并行执行;
+ * 否则按数组顺序串行执行. 记录每个阶段的开始/结束时刻与执行时间, 用于分析周期内的关键路径.
+ */
+#define SCHED_DAG_NODE_MAX (64) // 依赖以 u64 位图表示
+
+typedef struct {
+        const char *name; // 阶段名
+        sched_cb_f  f_cb; // 阶段函数
+        void       *arg;  // 阶段参数
+        u64         deps; // 前驱位图, 第 i 位表示依赖 nodes[i], 前驱下标须小于本节点
+} sched_dag_node_t;
+
+typedef struct {
+        sched_dag_node_t *nodes;    // 节点数组, 由调用者提供, 按拓扑序排列
+        usz               node_num; // 节点数量, 不超过 SCHED_DAG_NODE_MAX
+        sched_group_t    *group;    // 并行执行分支的调度组, NULL 时串行执行
+} sched_dag_cfg_t;
+
+struct sched_dag;
+
+typedef struct {
+        struct sched_dag *dag;
+        usz               idx; // 节点下标
+        sched_job_t       job; // 提交到调度组的任务
+} sched_dag_slot_t;
+
+typedef struct {
+        ATOMIC(u64) begin_ns;      // 最近一个周期的开始时刻, 相对 DAG 开始
+        ATOMIC(u64) end_ns;        // 最近一个周期的结束时刻, 相对 DAG 开始
+        sched_hist_counter_t exec; // 执行时间 (ns)
+} sched_dag_stage_t;
+
+/* 阶段统计快照 */
+typedef struct {
+        u64          begin_ns;
+        u64          end_ns;
+        sched_hist_t exec;
+} sched_dag_stage_stats_t;
+
+typedef struct {
+        u64                  succ[SCHED_DAG_NODE_MAX];     // 后继位图
+        u32                  pred_num[SCHED_DAG_NODE_MAX]; // 前驱数量
+        ATOMIC(u32)          pending[SCHED_DAG_NODE_MAX];  // 本周期尚未完成的前驱数量
+        ATOMIC(usz)          remain;                       // 本周期尚未完成的节点数量
+        u64                  start_ns;                     // 本周期开始时刻
+        sched_dag_slot_t     slots[SCHED_DAG_NODE_MAX];
+        sched_dag_stage_t    stages[SCHED_DAG_NODE_MAX];
+        sched_hist_counter_t span; // 整个 DAG 的耗时 (ns)
+} sched_dag_lo_t;
+
+typedef struct sched_dag {
+        sched_dag_cfg_t cfg;
+        sched_dag_lo_t  lo;
+} sched_dag_t;
+
+/* -------------------------------------------------------------------------- */
+/*                                   声明                                     */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief 初始化任务图
+ *
+ * @param dag
+ * @param dag_cfg
+ * @return 0 成功, -MEINVAL 节点数超限或前驱下标不小于本节点
+ */
+HAPI int sched_dag_init(sched_dag_t *dag, sched_dag_cfg_t dag_cfg);
+
+/**
+ * @brief 执行一个周期, 作为任务回调使用, 返回时所有阶段已完成
+ *
+ * 同一个 DAG 不能并发执行.
+ *
+ * @param arg sched_dag_t *
+ */
+HAPI void sched_dag_exec(void *arg);
+
+/**
+ * @brief 读取阶段统计快照, 任意线程可调用
+ *
+ * @param dag
+ * @param idx
+ * @param stats
+ */
+HAPI void sched_dag_stage_snapshot(sched_dag_t *dag, usz idx, sched_dag_stage_stats_t *stats);
+
+/**
+ * @brief 最近一个周期的关键路径: 从最晚结束的阶段起, 逐级回溯最晚结束的前驱
+ *
+ * @param dag
+ * @param path 输出节点下标, 从起点到终点
+ * @param cap path 容量
+ * @return 路径长度
+ */
+HAPI usz sched_dag_critical_path(sched_dag_t *dag, usz *path, usz cap);
+
+/* -------------------------------------------------------------------------- */
+/*                                   定义                                     */
+/* -------------------------------------------------------------------------- */
+
+HAPI void sched_dag_job(void *arg);
+
+HAPI int
+sched_dag_init(sched_dag_t *dag, sched_dag_cfg_t dag_cfg)
+{
+        DECL_PTRS(dag, cfg, lo);
+
+        if (!dag_cfg.nodes || !dag_cfg.node_num || dag_cfg.node_num > SCHED_DAG_NODE_MAX)
+                return -MEINVAL;
+
+        *cfg = dag_cfg;
+        memset(lo, 0, sizeof(sched_dag_lo_t));
+
+        for (usz i = 0; i < cfg->node_num; i++) {
+                const u64 deps = cfg->nodes[i].deps;
+                if (!cfg->nodes[i].f_cb || (deps >> i))
+                        return -MEINVAL;
+
+                lo->pred_num[i] = popcount64(deps);
+                for (usz j = 0; j < i; j++) {
+                        if (deps & (1ULL << j))
+                                lo->succ[j] |= 1ULL << i;
+                }
+
+                lo->slots[i].dag = dag;
+                lo->slots[i].idx = i;
+                lo->slots[i].job = (sched_job_t){.f_cb = sched_dag_job, .arg = &lo->slots[i]};
+        }
+        return 0;
+}
+
+HAPI void
+sched_dag_run_node(sched_dag_t *dag, const usz idx)
+{
+        DECL_PTRS(dag, cfg, lo);
+
+        const sched_dag_node_t *node  = &cfg->nodes[idx];
+        sched_dag_stage_t      *stage = &lo->stages[idx];
+
+        const u64 begin_ns = get_mono_ts_ns();
+        node->f_cb(node->arg);
+        const u64 end_ns = get_mono_ts_ns();
+
+        ATOMIC_STORE_EXPLICIT(&stage->begin_ns, begin_ns - lo->start_ns, memory_order_relaxed);
+        ATOMIC_STORE_EXPLICIT(&stage->end_ns, end_ns - lo->start_ns, memory_order_relaxed);
+        sched_hist_record(&stage->exec, end_ns - begin_ns);
+}
+
+/* 执行节点, 之后沿第一个就绪的后继继续执行, 其余就绪的后继提交到调度组 */
+HAPI void
+sched_dag_chain(sched_dag_t *dag, usz idx)
+{
+        DECL_PTRS(dag, cfg, lo);
+
+        for (;;) {
+                sched_dag_run_node(dag, idx);
+
+                isz next = -1;
+                u64 succ = lo->succ[idx];
+                while (succ) {
+                        const usz s = lsb64(succ);
+                        succ       &= succ - 1;
+                        if (ATOMIC_FETCH_SUB_EXPLICIT(&lo->pending[s], 1, memory_order_acq_rel) != 1)
+                                continue;
+                        if (next < 0)
+                                next = (isz)s;
+                        else if (sched_group_submit(cfg->group, &lo->slots[s].job) < 0)
+                                sched_dag_chain(dag, s); // 队列已满, 在本线程执行
+                }
+
+                ATOMIC_FETCH_SUB_EXPLICIT(&lo->remain, 1, memory_order_release);
+                if (next < 0)
+                        return;
+                idx = (usz)next;
+        }
+}
+
+HAPI void
+sched_dag_job(void *arg)
+{
+        sched_dag_slot_t *slot = (sched_dag_slot_t *)arg;
+        sched_dag_chain(slot->dag, slot->idx);
+}
+
+HAPI void
+sched_dag_exec(void *arg)
+{
+        sched_dag_t *dag = (sched_dag_t *)arg;
+        DECL_PTRS(dag, cfg, lo);
+
+        lo->start_ns = get_mono_ts_ns();
+
+        if (!cfg->group) {
+                for (usz i = 0; i < cfg->node_num; i++)
+                        sched_dag_run_node(dag, i);
+        } else {
+                for (usz i = 0; i < cfg->node_num; i++)
+                        ATOMIC_STORE_EXPLICIT(&lo->pending[i], lo->pred_num[i], memory_order_relaxed);
+                ATOMIC_STORE_EXPLICIT(&lo->remain, cfg->node_num, memory_order_release);
+
+                // 除第一个入口节点外都提交到调度组, 第一个在本线程执行
+                isz first = -1;
+                for (usz i = 0; i < cfg->node_num; i++) {
+                        if (lo->pred_num[i])
+                                continue;
+                        if (first < 0)
+                                first = (isz)i;
+                        else if (sched_group_submit(cfg->group, &lo->slots[i].job) < 0)
+                                sched_dag_chain(dag, i);
+                }
+                sched_dag_chain(dag, (usz)first);
+
+                // 等待其它分支完成, 工作者线程在等待期间执行其它任务
+                while (ATOMIC_LOAD_EXPLICIT(&lo->remain, memory_order_acquire) != 0) {
+                        if (!sched_worker_curr || !sched_worker_run_job(sched_worker_curr))
+                                CPU_RELAX();
+                }
+        }
+
+        sched_hist_record(&lo->span, get_mono_ts_ns() - lo->start_ns);
+}
+
+HAPI void
+sched_dag_stage_snapshot(sched_dag_t *dag, const usz idx, sched_dag_stage_stats_t *stats)
+{
+        DECL_PTRS(dag, lo);
+
+        const sched_dag_stage_t *stage = &lo->stages[idx];
+        stats->begin_ns                = sched_stat_load(&stage->begin_ns);
+        stats->end_ns                  = sched_stat_load(&stage->end_ns);
+        sched_hist_snapshot(&stage->exec, &stats->exec);
+}
+
+HAPI usz
+sched_dag_critical_path(sched_dag_t *dag, usz *path, const usz cap)
+{
+        DECL_PTRS(dag, cfg, lo);
+
+        if (!cap)
+                return 0;
+
+        // 最晚结束的阶段
+        usz idx = 0;
+        for (usz i = 1; i < cfg->node_num; i++) {
+                if (sched_stat_load(&lo->stages[i].end_ns) > sched_stat_load(&lo->stages[idx].end_ns))
+                        idx = i;
+        }
+
+        usz len = 0;
+        for (;;) {
+                path[len++] = idx;
+                u64 deps    = cfg->nodes[idx].deps;
+                if (!deps || len == cap)
+                        break;
+
+                usz pred = lsb64(deps);
+                while (deps) {
+                        const usz p = lsb64(deps);
+                        deps       &= deps - 1;
+                        if (sched_stat_load(&lo->stages[p].end_ns) > sched_stat_load(&lo->stages[pred].end_ns))
+                                pred = p;
+                }
+                idx = pred;
+        }
+
+        // 回溯得到的是终点到起点, 翻转
+        for (usz i = 0; i < len / 2; i++) {
+                const usz tmp     = path[i];
+                path[i]           = path[len - 1 - i];
+                path[len - 1 - i] = tmp;
+        }
+        return len;
+}
+
+#endif // !SCHED_DAG_H
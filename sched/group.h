@@ -0,0 +1,352 @@
+#ifndef SCHED_GROUP_H
+#define SCHED_GROUP_H
+
+#include "../ds/mpmc.h"
+#include "../ds/spsc.h"
+#include "../ds/wsdeque.h"
+#include "../util/errdef.h"
+#include "../util/macrodef.h"
+#include "../util/typedef.h"
+
+#include "sched.h"
+#include "thread.h"
+
+/*
+ * 多核调度组: 每个工作者绑定一个核, 持有一个 sched_t 执行固定在本核的周期任务,
+ * 以及一个 Chase-Lev 队列存放一次性任务. 工作者在周期任务之间依次从本地队列、
+ * 外部提交队列取任务, 都为空时随机窃取其它工作者的任务, 使一次性任务溢出到空闲核.
+ * 周期任务不会迁移.
+ *
+ * 没有可执行的任务时按工作者调度器的 e_idle 等待: SCHED_IDLE_SLEEP 在 futex 上休眠到下一次周期释放前
+ * spin_window, 提交一次性任务时唤醒; 进入自旋窗口后回到主循环轮询. SCHED_IDLE_SPIN 只让出 CPU.
+ */
+
+struct sched_group;
+
+typedef struct {
+        sched_cb_f f_cb; // 任务函数
+        void      *arg;  // 任务参数
+} sched_job_t;
+
+typedef struct {
+        sched_t             sched;  // 固定在本核的周期任务
+        wsdeque_t           jobs;   // 一次性任务
+        struct sched_group *group;  // 所属调度组
+        usz                 idx;    // 工作者编号
+        u8                  cpu_id; // 绑定的 CPU
+        u64                 rand;   // 选择窃取目标的随机状态
+        ATOMIC(u64) job_cnt;        // 已执行的一次性任务数
+        ATOMIC(u64) steal_cnt;      // 其中窃取所得的任务数
+} sched_worker_t;
+
+typedef struct {
+        sched_worker_t *workers;    // 工作者数组, 由调用者提供
+        usz             worker_num; // 工作者数量
+        void           *job_buf;    // 工作者队列存储, 至少 worker_num * job_cap 个 usz
+        usz             job_cap;    // 每个工作者队列容量(2^n), 同时是外部提交队列容量
+        void           *inject_buf; // 外部提交队列存储, 至少 MPMC_BUF_SIZE(job_cap, sizeof(sched_job_t *))
+} sched_group_cfg_t;
+
+typedef struct {
+        mpmc_t inject; // 外部提交队列
+        ATOMIC(bool) running;
+        ATOMIC(usz) alive;    // 运行中的工作者线程数
+        ATOMIC(u32) job_seq;  // futex 等待字, 有休眠的工作者时提交任务递增
+        ATOMIC(u32) sleepers; // 休眠中的工作者数量
+} sched_group_lo_t;
+
+typedef struct sched_group {
+        sched_group_cfg_t cfg;
+        sched_group_lo_t  lo;
+} sched_group_t;
+
+/* 当前线程所属的工作者, 非工作者线程为 NULL */
+static THREAD_LOCAL sched_worker_t *sched_worker_curr;
+
+/* -------------------------------------------------------------------------- */
+/*                                   声明                                     */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief 初始化调度组, 不创建线程
+ *
+ * @param group
+ * @param group_cfg
+ * @param sched_cfgs worker_num 个调度器配置, cpu_id 为工作者绑定的 CPU
+ * @return 0 成功, 负数失败
+ */
+HAPI int sched_group_init(sched_group_t *group, sched_group_cfg_t group_cfg, const sched_cfg_t *sched_cfgs);
+
+/**
+ * @brief 在指定工作者上添加周期任务, 须在 sched_group_start 之前调用
+ *
+ * @param group
+ * @param worker_idx
+ * @param task_cfg
+ * @return 0 成功, 负数失败
+ */
+HAPI int sched_group_add_task(sched_group_t *group, usz worker_idx, sched_task_cfg_t task_cfg);
+
+/**
+ * @brief 创建并绑定所有工作者线程
+ *
+ * @param group
+ * @return 0 成功, 负数失败
+ */
+HAPI int sched_group_start(sched_group_t *group);
+
+/**
+ * @brief 提交一次性任务, 任意线程可调用
+ *
+ * 工作者线程提交到自己的队列, 其它线程提交到外部提交队列, 有休眠的工作者时唤醒.
+ * job 在执行完成前须保持有效.
+ *
+ * @param group
+ * @param job
+ * @return 0 成功, -MEAGAIN 队列已满
+ */
+HAPI int sched_group_submit(sched_group_t *group, sched_job_t *job);
+
+/**
+ * @brief 通知所有工作者退出并等待
+ *
+ * @param group
+ */
+HAPI void sched_group_stop(sched_group_t *group);
+
+/* -------------------------------------------------------------------------- */
+/*                                   定义                                     */
+/* -------------------------------------------------------------------------- */
+
+HAPI int
+sched_group_init(sched_group_t *group, sched_group_cfg_t group_cfg, const sched_cfg_t *sched_cfgs)
+{
+        DECL_PTRS(group, cfg, lo);
+
+        if (!group_cfg.workers || !group_cfg.worker_num || !group_cfg.job_buf || !group_cfg.inject_buf || !sched_cfgs)
+                return -MEINVAL;
+
+        *cfg = group_cfg;
+        if (mpmc_init(&lo->inject, cfg->inject_buf, cfg->job_cap, sizeof(sched_job_t *)) < 0)
+                return -MEINVAL;
+        ATOMIC_STORE_EXPLICIT(&lo->running, false, memory_order_relaxed);
+        ATOMIC_STORE_EXPLICIT(&lo->alive, 0, memory_order_relaxed);
+        ATOMIC_STORE_EXPLICIT(&lo->job_seq, 0, memory_order_relaxed);
+        ATOMIC_STORE_EXPLICIT(&lo->sleepers, 0, memory_order_relaxed);
+
+        for (usz i = 0; i < cfg->worker_num; i++) {
+                sched_worker_t *worker = &cfg->workers[i];
+                worker->group          = group;
+                worker->idx            = i;
+                worker->cpu_id         = sched_cfgs[i].cpu_id;
+                worker->rand           = i * 0x9E3779B97F4A7C15ULL + 1;
+                ATOMIC_STORE_EXPLICIT(&worker->job_cnt, 0, memory_order_relaxed);
+                ATOMIC_STORE_EXPLICIT(&worker->steal_cnt, 0, memory_order_relaxed);
+
+                wsdeque_init(&worker->jobs, (usz *)cfg->job_buf + i * cfg->job_cap, cfg->job_cap);
+
+                // 调度器由工作者线程驱动, 不单独创建线程
+                sched_cfg_t sched_cfg = sched_cfgs[i];
+                sched_cfg.cpu_id      = SCHED_CPU_NONE;
+                const int ret         = sched_init(&worker->sched, sched_cfg);
+                if (ret < 0)
+                        return ret;
+        }
+        return 0;
+}
+
+HAPI int
+sched_group_add_task(sched_group_t *group, const usz worker_idx, sched_task_cfg_t task_cfg)
+{
+        DECL_PTRS(group, cfg);
+
+        if (worker_idx >= cfg->worker_num)
+                return -MEINVAL;
+        return sched_add_task(&cfg->workers[worker_idx].sched, task_cfg);
+}
+
+/* 唤醒休眠的工作者, 没有休眠者时只有一次内存屏障与一次读取, 不进入内核 */
+HAPI void
+sched_group_wake(sched_group_t *group)
+{
+        DECL_PTRS(group, lo);
+
+        // 与工作者的 sleepers 自增构成 Dekker 式配对: 要么此处看到休眠者, 要么工作者看到新任务
+        ATOMIC_THREAD_FENCE(memory_order_seq_cst);
+        if (ATOMIC_LOAD_EXPLICIT(&lo->sleepers, memory_order_relaxed) == 0)
+                return;
+
+        ATOMIC_FETCH_ADD_EXPLICIT(&lo->job_seq, 1, memory_order_release);
+        spsc_futex_wake(&lo->job_seq);
+}
+
+HAPI int
+sched_group_submit(sched_group_t *group, sched_job_t *job)
+{
+        DECL_PTRS(group, lo);
+
+        sched_worker_t *worker = sched_worker_curr;
+        const bool      local  = worker && worker->group == group && wsdeque_push(&worker->jobs, job);
+        if (!local && !mpmc_push(&lo->inject, &job))
+                return -MEAGAIN;
+
+        sched_group_wake(group);
+        return 0;
+}
+
+HAPI sched_job_t *
+sched_worker_steal(sched_worker_t *worker)
+{
+        DECL_PTRS(worker->group, cfg);
+
+        if (cfg->worker_num < 2)
+                return NULL;
+
+        // xorshift64 选择起点, 依次尝试其它工作者
+        worker->rand ^= worker->rand << 13;
+        worker->rand ^= worker->rand >> 7;
+        worker->rand ^= worker->rand << 17;
+
+        const usz start = (usz)(worker->rand % cfg->worker_num);
+        for (usz i = 0; i < cfg->worker_num; i++) {
+                const usz victim = (start + i) % cfg->worker_num;
+                if (victim == worker->idx)
+                        continue;
+                sched_job_t *job = (sched_job_t *)wsdeque_steal(&cfg->workers[victim].jobs);
+                if (job)
+                        return job;
+        }
+        return NULL;
+}
+
+/* 执行一个一次性任务, 没有可执行的任务时返回 false */
+HAPI bool
+sched_worker_run_job(sched_worker_t *worker)
+{
+        DECL_PTRS(worker->group, lo);
+
+        bool         stolen = false;
+        sched_job_t *job    = (sched_job_t *)wsdeque_pop(&worker->jobs);
+        if (!job && !mpmc_pop(&lo->inject, &job)) {
+                job    = sched_worker_steal(worker);
+                stolen = (job != NULL);
+        }
+        if (!job)
+                return false;
+
+        job->f_cb(job->arg);
+        ATOMIC_FETCH_ADD_EXPLICIT(&worker->job_cnt, 1, memory_order_relaxed);
+        if (stolen)
+                ATOMIC_FETCH_ADD_EXPLICIT(&worker->steal_cnt, 1, memory_order_relaxed);
+        return true;
+}
+
+/* 没有一次性任务时按 e_idle 等待, 休眠到下一次周期释放前 spin_window 或被提交唤醒 */
+HAPI void
+sched_worker_idle(sched_worker_t *worker)
+{
+        DECL_PTRS(worker->group, lo);
+        DECL_PTR_RENAME(&worker->sched, sched);
+
+        if (sched->cfg.virt || sched->cfg.e_idle != SCHED_IDLE_SLEEP) {
+                sched_thread_yield();
+                return;
+        }
+
+        const u64 next = sched_next_ts(sched);
+        const u64 now  = sched_now(sched);
+        if (next <= now)
+                return;
+
+        u64 sleep_ns = (next == UINT64_MAX) ? SCHED_IDLE_SLEEP_MAX_NS : sched_tick2ns(sched, next - now);
+        sleep_ns     = MIN(sleep_ns, SCHED_IDLE_SLEEP_MAX_NS);
+
+        // 自旋窗口内回到主循环, 同时轮询周期任务与一次性任务
+        const u64 window_ns = sched_tick2ns(sched, sched->cfg.spin_window);
+        if (sleep_ns <= window_ns)
+                return;
+
+        const u32 seq = ATOMIC_LOAD_EXPLICIT(&lo->job_seq, memory_order_acquire);
+        ATOMIC_FETCH_ADD_EXPLICIT(&lo->sleepers, 1, memory_order_seq_cst);
+
+        // 登记后再取一次任务, 登记前提交的任务在此取到, 之后提交的任务会改变 job_seq
+        if (!sched_worker_run_job(worker) && ATOMIC_LOAD_EXPLICIT(&lo->running, memory_order_relaxed)) {
+                const u64 begin_ns = get_mono_ts_ns();
+                spsc_futex_wait(&lo->job_seq, seq, sleep_ns - window_ns);
+
+                // 只统计按时唤醒的休眠, 被提交唤醒时没有唤醒延迟
+                const u64 wake_ns = begin_ns + sleep_ns - window_ns;
+                const u64 woke_ns = get_mono_ts_ns();
+                if (woke_ns >= wake_ns) {
+                        sched_idle_stat_t *idle  = &sched->lo.idle;
+                        idle->sleep_cnt++;
+                        idle->wake_lat_ns_sum   += woke_ns - wake_ns;
+                        idle->wake_lat_ns_max    = MAX(idle->wake_lat_ns_max, woke_ns - wake_ns);
+                }
+        }
+        ATOMIC_FETCH_SUB_EXPLICIT(&lo->sleepers, 1, memory_order_relaxed);
+}
+
+HAPI void
+sched_worker_loop(sched_worker_t *worker)
+{
+        DECL_PTRS(worker->group, lo);
+
+        sched_worker_curr = worker;
+        while (ATOMIC_LOAD_EXPLICIT(&lo->running, memory_order_relaxed)) {
+                // 周期任务优先, 每轮最多插入一个一次性任务
+                sched_exec(&worker->sched);
+                if (!sched_worker_run_job(worker))
+                        sched_worker_idle(worker);
+        }
+        sched_worker_curr = NULL;
+        ATOMIC_FETCH_SUB_EXPLICIT(&lo->alive, 1, memory_order_release);
+}
+
+#ifdef __linux__
+HAPI void *
+sched_worker_exec(void *arg)
+{
+        sched_worker_loop((sched_worker_t *)arg);
+        return NULL;
+}
+#elif defined(_WIN32)
+HAPI DWORD WINAPI
+sched_worker_exec(LPVOID arg)
+{
+        sched_worker_loop((sched_worker_t *)arg);
+        return 0;
+}
+#endif
+
+HAPI int
+sched_group_start(sched_group_t *group)
+{
+        DECL_PTRS(group, cfg, lo);
+
+        ATOMIC_STORE_EXPLICIT(&lo->running, true, memory_order_relaxed);
+        for (usz i = 0; i < cfg->worker_num; i++) {
+                sched_worker_t *worker = &cfg->workers[i];
+                ATOMIC_FETCH_ADD_EXPLICIT(&lo->alive, 1, memory_order_relaxed);
+                const int ret = sched_thread_create(sched_worker_exec, worker, worker->cpu_id, &worker->sched.cfg.rt);
+                if (ret < 0) {
+                        ATOMIC_FETCH_SUB_EXPLICIT(&lo->alive, 1, memory_order_relaxed);
+                        sched_group_stop(group);
+                        return ret;
+                }
+        }
+        return 0;
+}
+
+HAPI void
+sched_group_stop(sched_group_t *group)
+{
+        DECL_PTRS(group, lo);
+
+        ATOMIC_STORE_EXPLICIT(&lo->running, false, memory_order_relaxed);
+        sched_group_wake(group);
+        while (ATOMIC_LOAD_EXPLICIT(&lo->alive, memory_order_acquire) != 0)
+                sched_thread_yield();
+}
+
+#endif // !SCHED_GROUP_H
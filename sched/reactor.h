@@ -0,0 +1,293 @@
+#ifndef SCHED_REACTOR_H
+#define SCHED_REACTOR_H
+
+#include "../comm/net.h"
+#include "../util/errdef.h"
+#include "../util/macrodef.h"
+#include "../util/mathdef.h"
+#include "../util/timeops.h"
+#include "../util/typedef.h"
+
+#include "coro.h"
+#include "sched.h"
+
+/*
+ * 反应器: 调度器的释放时刻与网络完成事件共用 net_t 的 io_uring.
+ * 下一次释放以 IORING_OP_TIMEOUT (CLOCK_MONOTONIC 绝对时间) 提交到同一个 ring, 一个线程阻塞等待 CQE,
+ * 定时器与网络完成先到者唤醒. 网络回调直接在反应器线程执行, 回调中可以唤醒或添加任务, 无需跨线程交接.
+ *
+ * 调度器不能创建自己的线程 (cpu_id = SCHED_CPU_NONE), ring 只能由反应器线程访问:
+ * net_async_send/net_async_recv 只能在任务回调或网络回调中调用, 不能再单独调用 net_poll.
+ * 空闲时总是阻塞在 ring 上, 不使用 e_idle; spin_window 仍然有效.
+ * 其它线程经命令队列修改任务, 最迟在 SCHED_IDLE_SLEEP_MAX_NS 后生效.
+ * io_uring 仅 Linux 可用.
+ */
+#ifdef __linux__
+
+#define SCHED_REACTOR_UD_TIMER (1ULL) // 定时器 user_data 最低位为 1, 高位为序号; 网络请求是对齐的指针, 最低位为 0
+
+typedef struct {
+        sched_t *sched; // 调度器, cpu_id 须为 SCHED_CPU_NONE 且不是虚拟时间模式
+        net_t   *net;   // 提供 io_uring 实例
+} sched_reactor_cfg_t;
+
+typedef struct {
+        u64 wait_cnt;  // 阻塞等待次数
+        u64 timer_cnt; // 定时器唤醒次数
+        u64 rearm_cnt; // 释放时刻变化, 撤销已提交的定时器重新提交的次数
+        u64 net_cnt;   // 处理的网络 CQE 数
+} sched_reactor_stat_t;
+
+typedef struct {
+        u64                      timer_seq; // 当前定时器序号, 撤销后到达的旧定时器 CQE 按序号忽略
+        u64                      timer_ns;  // 当前定时器的绝对唤醒时刻 (ns), 0 表示没有定时器
+        struct __kernel_timespec timer_ts;  // 提交时由内核读取
+        ATOMIC(bool) stop;
+        sched_reactor_stat_t stat;
+} sched_reactor_lo_t;
+
+typedef struct {
+        sched_reactor_cfg_t cfg;
+        sched_reactor_lo_t  lo;
+} sched_reactor_t;
+
+/* -------------------------------------------------------------------------- */
+/*                                   声明                                     */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief 初始化反应器
+ *
+ * @param rt
+ * @param rt_cfg
+ * @return 0 成功, -MEINVAL 调度器有自己的线程或是虚拟时间模式
+ */
+HAPI int sched_reactor_init(sched_reactor_t *rt, sched_reactor_cfg_t rt_cfg);
+
+/**
+ * @brief 反应器的一次循环: 执行到期任务, 处理已完成的网络请求, 再阻塞到下一次释放或下一个网络完成
+ *
+ * 定时器设在释放前 spin_window, 之后自旋到释放时刻, 自旋期间仍处理网络完成.
+ *
+ * @param rt
+ */
+HAPI void sched_reactor_poll(sched_reactor_t *rt);
+
+/**
+ * @brief 在当前线程循环 sched_reactor_poll, 直到 sched_reactor_stop
+ *
+ * @param rt
+ */
+HAPI void sched_reactor_run(sched_reactor_t *rt);
+
+/**
+ * @brief 唤醒协程的网络回调: 通道的 arg 为等待中的 sched_coro_t *, 以 cqe->res 唤醒
+ *
+ * 作为 f_recv_cb 使用, 协程在发起请求后以 SCHED_CORO_AWAIT 等待, 结果在 lo.res.
+ *
+ * @param ch
+ * @param buf
+ * @param ret
+ */
+HAPI void sched_coro_net_cb(net_ch_t *ch, void *buf, int ret);
+
+/**
+ * @brief 请求 sched_reactor_run 返回, 任意线程可调用, 最迟在下一次唤醒后生效
+ *
+ * @param rt
+ */
+HAPI void sched_reactor_stop(sched_reactor_t *rt);
+
+/* -------------------------------------------------------------------------- */
+/*                                   定义                                     */
+/* -------------------------------------------------------------------------- */
+
+HAPI int
+sched_reactor_init(sched_reactor_t *rt, const sched_reactor_cfg_t rt_cfg)
+{
+        DECL_PTRS(rt, cfg, lo);
+
+        if (!rt_cfg.sched || !rt_cfg.net)
+                return -MEINVAL;
+        if (rt_cfg.sched->cfg.virt || rt_cfg.sched->cfg.cpu_id != SCHED_CPU_NONE)
+                return -MEINVAL;
+
+        *cfg = rt_cfg;
+        memset(lo, 0, sizeof(sched_reactor_lo_t));
+        return 0;
+}
+
+/* io_uring 绝对超时使用 CLOCK_MONOTONIC, 与 get_mono_ts_ns 的 CLOCK_MONOTONIC_RAW 不同 */
+HAPI u64
+sched_reactor_now_ns(void)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (u64)ts.tv_sec * NANO_PER_SEC + (u64)ts.tv_nsec;
+}
+
+/* SQ 已满时先提交再取 */
+HAPI struct io_uring_sqe *
+sched_reactor_sqe(sched_reactor_t *rt)
+{
+        struct io_uring     *ring = &rt->cfg.net->lo.ring;
+        struct io_uring_sqe *sqe  = io_uring_get_sqe(ring);
+        if (!sqe) {
+                io_uring_submit(ring);
+                sqe = io_uring_get_sqe(ring);
+        }
+        return sqe;
+}
+
+/*
+ * 设置 wake_ns 的定时器. tick 换算为 ns 时有一个 tick 以内的相位误差,
+ * 已有定时器与 wake_ns 相差不足一个 tick 时沿用, 晚到的部分由自旋窗口吸收; 否则撤销后重新提交.
+ */
+HAPI void
+sched_reactor_arm(sched_reactor_t *rt, const u64 wake_ns)
+{
+        DECL_PTRS(rt, cfg, lo);
+
+        const u64 tick_ns = sched_tick2ns(cfg->sched, 1);
+        if (lo->timer_ns && lo->timer_ns < wake_ns + tick_ns && wake_ns < lo->timer_ns + tick_ns)
+                return;
+
+        struct io_uring_sqe *sqe;
+        if (lo->timer_ns) {
+                if (!(sqe = sched_reactor_sqe(rt)))
+                        return;
+                io_uring_prep_timeout_remove(sqe, (lo->timer_seq << 1) | SCHED_REACTOR_UD_TIMER, 0);
+                io_uring_sqe_set_data64(sqe, 0);
+                lo->stat.rearm_cnt++;
+        }
+
+        if (!(sqe = sched_reactor_sqe(rt))) {
+                lo->timer_ns = 0;
+                return;
+        }
+        lo->timer_seq++;
+        lo->timer_ns         = wake_ns;
+        lo->timer_ts.tv_sec  = (long long)(wake_ns / NANO_PER_SEC);
+        lo->timer_ts.tv_nsec = (long long)(wake_ns % NANO_PER_SEC);
+        io_uring_prep_timeout(sqe, &lo->timer_ts, 0, IORING_TIMEOUT_ABS);
+        io_uring_sqe_set_data64(sqe, (lo->timer_seq << 1) | SCHED_REACTOR_UD_TIMER);
+}
+
+/* 处理已到达的 CQE, 不阻塞, 返回其中网络 CQE 的数量 */
+HAPI usz
+sched_reactor_reap(sched_reactor_t *rt)
+{
+        DECL_PTRS(rt, cfg, lo);
+
+        struct io_uring     *ring = &cfg->net->lo.ring;
+        struct io_uring_cqe *cqe;
+        usz                  cnt = 0;
+        while (io_uring_peek_cqe(ring, &cqe) == 0) {
+                const u64 ud = cqe->user_data;
+                if (ud & SCHED_REACTOR_UD_TIMER) {
+                        // 被撤销的旧定时器以 -ECANCELED 到达, 序号不同, 忽略
+                        if ((ud >> 1) == lo->timer_seq && lo->timer_ns) {
+                                if (cqe->res == -ETIME) {
+                                        const u64 now_ns = sched_reactor_now_ns();
+                                        const u64 lat_ns = (now_ns > lo->timer_ns) ? now_ns - lo->timer_ns : 0;
+
+                                        sched_idle_stat_t *idle  = &cfg->sched->lo.idle;
+                                        idle->sleep_cnt++;
+                                        idle->wake_lat_ns_sum   += lat_ns;
+                                        idle->wake_lat_ns_max    = MAX(idle->wake_lat_ns_max, lat_ns);
+                                        lo->stat.timer_cnt++;
+                                }
+                                lo->timer_ns = 0;
+                        }
+                } else if (ud) {
+                        net_cqe_dispatch(cfg->net, cqe);
+                        lo->stat.net_cnt++;
+                        cnt++;
+                }
+                io_uring_cqe_seen(ring, cqe);
+        }
+        return cnt;
+}
+
+HAPI void
+sched_reactor_poll(sched_reactor_t *rt)
+{
+        DECL_PTRS(rt, cfg, lo);
+        DECL_PTR_RENAME(cfg->sched, sched);
+
+        sched_exec(sched);
+
+        // 网络回调可能唤醒或添加任务, 回到 sched_exec
+        if (sched_reactor_reap(rt))
+                return;
+
+        const u64 next = sched_next_ts(sched);
+        const u64 now  = sched_now(sched);
+        if (next <= now)
+                return;
+
+        u64 sleep_ns = (next == UINT64_MAX) ? SCHED_IDLE_SLEEP_MAX_NS : sched_tick2ns(sched, next - now);
+        sleep_ns     = MIN(sleep_ns, SCHED_IDLE_SLEEP_MAX_NS);
+
+        const u64 window_ns = sched_tick2ns(sched, sched->cfg.spin_window);
+        if (sleep_ns > window_ns) {
+                sched_reactor_arm(rt, sched_reactor_now_ns() + sleep_ns - window_ns);
+                io_uring_submit_and_wait(&cfg->net->lo.ring, 1);
+                lo->stat.wait_cnt++;
+
+                // 网络完成或撤销产生的 CQE 唤醒时定时器仍在, 重新计算
+                if (sched_reactor_reap(rt) || lo->timer_ns)
+                        return;
+        }
+
+        if (next == UINT64_MAX)
+                return;
+
+        // 自旋窗口: 只读时钟和完成队列
+        if (sched_now(sched) > next) {
+                sched->lo.idle.late_cnt++;
+                return;
+        }
+        while (sched_now(sched) < next) {
+                if (sched_reactor_reap(rt))
+                        return;
+                CPU_RELAX();
+        }
+}
+
+HAPI void
+sched_reactor_run(sched_reactor_t *rt)
+{
+        DECL_PTRS(rt, cfg, lo);
+
+        while (!ATOMIC_LOAD_EXPLICIT(&lo->stop, memory_order_acquire))
+                sched_reactor_poll(rt);
+
+        // 撤销未到期的定时器并等待其 CQE, 之后 ring 中不再有定时器的 CQE, 可以交还给 net_poll
+        struct io_uring_sqe *sqe;
+        if (lo->timer_ns && (sqe = sched_reactor_sqe(rt))) {
+                io_uring_prep_timeout_remove(sqe, (lo->timer_seq << 1) | SCHED_REACTOR_UD_TIMER, 0);
+                io_uring_sqe_set_data64(sqe, 0);
+        }
+        while (lo->timer_ns) {
+                io_uring_submit_and_wait(&cfg->net->lo.ring, 1);
+                sched_reactor_reap(rt);
+        }
+}
+
+HAPI void
+sched_coro_net_cb(net_ch_t *ch, void *buf, const int ret)
+{
+        ARG_UNUSED(buf);
+        sched_coro_wake((sched_coro_t *)ch->arg, ret);
+}
+
+HAPI void
+sched_reactor_stop(sched_reactor_t *rt)
+{
+        ATOMIC_STORE_EXPLICIT(&rt->lo.stop, true, memory_order_release);
+}
+
+#endif // __linux__
+
+#endif // !SCHED_REACTOR_H
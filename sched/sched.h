@@ -3,15 +3,22 @@
 
 #include <string.h>
 
+#include "../ds/dheap.h"
+#include "../ds/list.h"
+#include "../ds/mpmc.h"
 #include "../ds/rbtree.h"
+#include "../ds/twheel.h"
 #include "../util/errdef.h"
+#include "../util/mathdef.h"
 #include "../util/timeops.h"
 
+#include "stats.h"
 #include "thread.h"
 
-#ifndef SCHED_TASK_MAX
-#define SCHED_TASK_MAX 8
-#endif
+#define SCHED_CPU_NONE          (0xFF)        // 不创建调度线程, 由调用者驱动 sched_exec
+#define SCHED_EDF_PRIO_BITS     (8)           // EDF 堆键低位存放优先级, 截止期相同时按优先级排序
+#define SCHED_IDLE_SLEEP_MAX_NS (10000000ULL) // 无任务时单次休眠上限, 10 ms
+#define SCHED_WAKE_NEVER        (~(usz)0)     // sched_task_sleep 不设超时, 只由 sched_task_wake 唤醒
 
 typedef void (*sched_cb_f)(void *arg);
 
@@ -22,6 +29,16 @@ typedef union {
         struct {
                 rb_root_t rb_root;
         } cfs;
+        struct {
+                twheel_t    tw;    // 按 next_exec_ts 挂入时间轮
+                list_head_t ready; // 已到期待执行
+        } wheel;
+        struct {
+                twheel_t    tw;       // 未释放的任务, 按 next_exec_ts 挂入时间轮
+                list_head_t released; // 时间轮输出的暂存链表
+                dheap_t     ready;    // 已释放的任务, 按绝对截止期排序
+                f64         util;     // 已准入任务的总利用率
+        } edf;
 } sched_algo_ctx;
 
 /*
@@ -45,19 +62,30 @@ typedef union {
  */
 typedef enum {
         SCHED_TASK_STATE_RUNNING,  // 就绪或运行
-        SCHED_TASK_STATE_SLEEPING, // 阻塞
+        SCHED_TASK_STATE_SLEEPING, // 阻塞, 等待 sched_task_wake 或超时
         SCHED_TASK_STATE_STOPPED,  // 手动挂起
         SCHED_TASK_STATE_DEAD,     // 已结束
 } sched_task_state_e;
 
+/* 释放时刻锚定在 phase_ts + k * 周期, 执行结束时已错过下一次释放的处理方式 */
+typedef enum {
+        SCHED_OVERRUN_SKIP,    // 跳过已错过的释放, 对齐到下一个周期边界
+        SCHED_OVERRUN_CATCHUP, // 立即补执行错过的释放, 连续补执行超过 burst_max 次后跳过其余
+        SCHED_OVERRUN_REPHASE, // 以本次结束时刻为新的相位
+} sched_overrun_e;
+
 typedef struct {
-        usz        id;           // 任务 ID
-        u32        priority;     // 任务优先级, 数值越小优先级越高
-        usz        exec_freq;    // 执行频率
-        usz        exec_cnt_max; // 最多执行次数
-        usz        delay_tick;   // 初始延时
-        sched_cb_f f_cb;         // 回调函数
-        void      *arg;          // 回调参数
+        usz             id;           // 任务 ID
+        u32             priority;     // 任务优先级, 数值越小优先级越高
+        usz             exec_freq;    // 执行频率
+        usz             exec_cnt_max; // 最多执行次数
+        usz             delay_tick;   // 初始延时
+        usz             deadline;     // 相对截止期 (tick), 0 表示等于周期
+        usz             wcet;         // 最坏执行时间 (tick), EDF 准入控制使用
+        sched_overrun_e e_overrun;    // 错过释放时的处理方式
+        usz             burst_max;    // SCHED_OVERRUN_CATCHUP 连续补执行次数上限, 0 不限
+        sched_cb_f      f_cb;         // 回调函数
+        void           *arg;          // 回调参数
 } sched_task_cfg_t;
 
 typedef struct {
@@ -66,14 +94,39 @@ typedef struct {
         f32                elapsed_us;
         usz                create_ts;
         usz                next_exec_ts;
+        usz                abs_deadline; // 本次释放的绝对截止期
+        usz                miss_cnt;     // 截止期错过次数
+        usz                phase_ts;     // 释放相位, 第 k 次释放在 phase_ts + k * 周期
+        usz                release_cnt;  // 下一次释放的序号 k
+        usz                burst;        // 连续补执行次数
 } sched_task_status_t;
 
 typedef struct {
-        sched_task_cfg_t    cfg;
-        sched_task_status_t status;
-        rb_node_t           rb_node;
+        sched_task_cfg_t     cfg;
+        sched_task_status_t  status;
+        sched_task_counter_t stats;    // 可由其它线程读取的统计
+        list_head_t          due_node; // 本轮到期链表节点
+        rb_node_t            rb_node;
+        twheel_node_t        tw_node;
+        dheap_node_t         dh_node;
 } sched_task_t;
 
+/* 其它线程经命令队列修改任务, 由调度线程在每次 sched_exec 开始时执行 */
+typedef enum {
+        SCHED_CMD_ADD,    // 添加任务, 使用整个 task_cfg
+        SCHED_CMD_REMOVE, // 移除任务
+        SCHED_CMD_PAUSE,  // 挂起任务
+        SCHED_CMD_RESUME, // 恢复任务, 已错过的释放立即执行
+        SCHED_CMD_RETUNE, // 修改执行频率为 task_cfg.exec_freq, 从下一次释放开始生效
+} sched_cmd_e;
+
+typedef struct {
+        sched_cmd_e      e_cmd;
+        sched_task_cfg_t task_cfg; // 除 SCHED_CMD_ADD 外按 task_cfg.id 查找任务
+} sched_cmd_t;
+
+#define SCHED_CMD_BUF_SIZE(cap) MPMC_BUF_SIZE(cap, sizeof(sched_cmd_t)) // 命令队列所需缓冲区字节数
+
 typedef u64 (*sched_get_ts_f)(void);
 typedef sched_task_t *(*sched_get_task_f)(struct sched *sched);
 typedef void (*sched_insert_task_f)(struct sched *sched, sched_task_t *task);
@@ -82,6 +135,8 @@ typedef void (*sched_remove_task_f)(struct sched *sched, sched_task_t *task);
 typedef enum {
         SCHED_TYPE_FCFS,
         SCHED_TYPE_CFS,
+        SCHED_TYPE_WHEEL,
+        SCHED_TYPE_EDF,
 } sched_type_e;
 
 typedef enum {
@@ -89,22 +144,48 @@ typedef enum {
         SCHED_TICK_MS,
 } sched_tick_e;
 
+typedef enum {
+        SCHED_IDLE_SPIN,  // 持续轮询
+        SCHED_IDLE_SLEEP, // 休眠到下一次释放前 spin_window, 再自旋到释放时刻
+} sched_idle_e;
+
+typedef struct {
+        u64 sleep_cnt;       // 休眠次数
+        u64 wake_lat_ns_sum; // 休眠唤醒延迟之和 (实际唤醒时刻 - 请求唤醒时刻)
+        u64 wake_lat_ns_max; // 最大唤醒延迟
+        u64 late_cnt;        // 自旋结束时已晚于释放时刻的次数 (spin_window 不足)
+} sched_idle_stat_t;
+
 typedef struct {
         u8             cpu_id;
         sched_type_e   e_type;
         sched_tick_e   e_tick;
         sched_get_ts_f f_get_ts;
+        sched_task_t  *tasks;       // 任务数组, 由调用者提供
+        usz            task_max;    // 任务数组长度
+        dheap_entry_t *heap_buf;    // SCHED_TYPE_EDF 就绪堆存储, 长度不小于 task_max
+        sched_idle_e   e_idle;      // 空闲策略
+        usz            spin_window; // SCHED_IDLE_SLEEP 释放前的自旋窗口 (tick)
+        sched_rt_cfg_t rt;          // 调度线程的实时设置
+        void          *cmd_buf;     // 命令队列存储, 至少 SCHED_CMD_BUF_SIZE(cmd_cap) 字节, NULL 不启用
+        usz            cmd_cap;     // 命令队列容量(2^n)
+        bool           virt;        // 虚拟时间模式: 不创建线程, 不使用 f_get_ts, 时间只由 sched_run_until 推进
 } sched_cfg_t;
 
 typedef struct {
         f32                 elapsed_us;
         usz                 curr_ts;
         usz                 task_num;
-        sched_task_t        tasks[SCHED_TASK_MAX];
         sched_algo_ctx      algo_ctx;
         sched_get_task_f    f_get_task;
         sched_insert_task_f f_insert_task;
         sched_remove_task_f f_remove_task;
+        sched_idle_stat_t   idle;
+        sched_counter_t     stats;
+        mpmc_t              cmd;     // 命令队列
+        list_head_t         due;     // 本轮到期的任务, 按优先级排序
+        sched_task_t       *running; // 正在执行回调的任务, 回调期间不复用其位置
+        ATOMIC(u64) virt_ts; // 虚拟时间模式的当前时刻, 调度线程写, 快照可由其它线程读
 } sched_lo_t;
 
 typedef struct sched {
@@ -112,6 +193,39 @@ typedef struct sched {
         sched_lo_t  lo;
 } sched_t;
 
+/**
+ * @brief 调度器的当前时刻, 虚拟时间模式下为虚拟时钟
+ *
+ * 虚拟时间模式下任务回调应使用它代替系统时钟.
+ *
+ * @param sched
+ * @return u64
+ */
+HAPI u64
+sched_now(sched_t *sched)
+{
+        DECL_PTRS(sched, cfg, lo);
+
+        return cfg->virt ? ATOMIC_LOAD_EXPLICIT(&lo->virt_ts, memory_order_relaxed) : cfg->f_get_ts();
+}
+
+/**
+ * @brief 虚拟时间模式下在回调中调用, 模拟回调消耗 tick 的执行时间
+ *
+ * 执行时间计入统计与截止期判断, 推进后到期的任务在本次 sched_run_until 中继续执行.
+ *
+ * @param sched
+ * @param tick
+ */
+HAPI void
+sched_consume(sched_t *sched, const u64 tick)
+{
+        DECL_PTRS(sched, cfg, lo);
+
+        if (cfg->virt)
+                sched_stat_add(&lo->virt_ts, tick);
+}
+
 HAPI u64
 sched_hz2tick(sched_t *sched, const f32 hz)
 {
@@ -127,6 +241,65 @@ sched_hz2tick(sched_t *sched, const f32 hz)
         }
 }
 
+HAPI u64
+sched_task_period(sched_t *sched, const sched_task_cfg_t *task_cfg)
+{
+        return task_cfg->exec_freq ? sched_hz2tick(sched, (f32)task_cfg->exec_freq) : 0;
+}
+
+HAPI u64
+sched_task_deadline(sched_t *sched, const sched_task_cfg_t *task_cfg)
+{
+        return task_cfg->deadline ? task_cfg->deadline : sched_task_period(sched, task_cfg);
+}
+
+/* 截止期小于周期时用密度 wcet / min(D, T) 代替利用率, 总和不超过 1 是 EDF 可调度的充分条件 */
+HAPI f64
+sched_task_util(sched_t *sched, const sched_task_cfg_t *task_cfg)
+{
+        const u64 period   = sched_task_period(sched, task_cfg);
+        const u64 deadline = sched_task_deadline(sched, task_cfg);
+        const u64 window   = (period && deadline) ? MIN(period, deadline) : MAX(period, deadline);
+        return window ? (f64)task_cfg->wcet / (f64)window : 0;
+}
+
+HAPI u64
+sched_tick2ns(sched_t *sched, const u64 tick)
+{
+        DECL_PTRS(sched, cfg);
+
+        switch (cfg->e_tick) {
+                case SCHED_TICK_US:
+                        return US2NS(tick);
+                case SCHED_TICK_MS:
+                        return MS2NS(tick);
+                default:
+                        return 0;
+        }
+}
+
+HAPI u64
+sched_tick_per_sec(sched_t *sched)
+{
+        DECL_PTRS(sched, cfg);
+
+        switch (cfg->e_tick) {
+                case SCHED_TICK_US:
+                        return MICRO_PER_SEC;
+                case SCHED_TICK_MS:
+                        return MILLI_PER_SEC;
+                default:
+                        return 0;
+        }
+}
+
+/* 第 k 次释放时刻, 整数运算, 非整数周期也不累积误差 */
+HAPI u64
+sched_task_release(sched_t *sched, const sched_task_t *task, const u64 k)
+{
+        return task->status.phase_ts + k * sched_tick_per_sec(sched) / task->cfg.exec_freq;
+}
+
 HAPI int
 sched_cfs_task_cmp(const sched_task_t *a, const sched_task_t *b)
 {
@@ -150,9 +323,6 @@ sched_cfs_insert_task(sched_t *sched, sched_task_t *task)
         rb_node_t **new_rb_node = &rb_root->rb_node;
         rb_node_t  *rb_parent   = NULL;
 
-        if (task->cfg.id >= SCHED_TASK_MAX)
-                return;
-
         while (*new_rb_node) {
                 sched_task_t *curr = CONTAINER_OF(*new_rb_node, sched_task_t, rb_node);
                 int           cmp  = sched_cfs_task_cmp(task, curr);
@@ -187,15 +357,90 @@ sched_cfs_get_task(sched_t *sched)
         return CONTAINER_OF(rb_node, sched_task_t, rb_node);
 }
 
+HAPI void
+sched_wheel_insert_task(sched_t *sched, sched_task_t *task)
+{
+        DECL_PTRS(sched, lo);
+
+        twheel_add(&lo->algo_ctx.wheel.tw, &task->tw_node, task->status.next_exec_ts);
+}
+
+HAPI void
+sched_wheel_remove_task(sched_t *sched, sched_task_t *task)
+{
+        DECL_PTRS(sched, lo);
+
+        // 无论在时间轮中还是在就绪链表中都可直接摘除
+        twheel_del(&lo->algo_ctx.wheel.tw, &task->tw_node);
+}
+
 HAPI sched_task_t *
-sched_fcfs_get_task(sched_t *sched)
+sched_wheel_get_task(sched_t *sched)
+{
+        DECL_PTRS(sched, lo);
+
+        list_head_t *ready = &lo->algo_ctx.wheel.ready;
+        twheel_advance(&lo->algo_ctx.wheel.tw, lo->curr_ts, ready);
+        if (list_empty(ready))
+                return NULL;
+        return CONTAINER_OF(CONTAINER_OF(ready->next, twheel_node_t, node), sched_task_t, tw_node);
+}
+
+HAPI u64
+sched_edf_key(const sched_task_t *task)
+{
+        const u64 prio = MIN(task->cfg.priority, (1U << SCHED_EDF_PRIO_BITS) - 1);
+        return ((u64)task->status.abs_deadline << SCHED_EDF_PRIO_BITS) | prio;
+}
+
+HAPI void
+sched_edf_insert_task(sched_t *sched, sched_task_t *task)
 {
         DECL_PTRS(sched, lo);
 
+        twheel_add(&lo->algo_ctx.edf.tw, &task->tw_node, task->status.next_exec_ts);
+}
+
+HAPI void
+sched_edf_remove_task(sched_t *sched, sched_task_t *task)
+{
+        DECL_PTRS(sched, lo);
+
+        twheel_del(&lo->algo_ctx.edf.tw, &task->tw_node);
+        dheap_del(&lo->algo_ctx.edf.ready, &task->dh_node);
+}
+
+HAPI sched_task_t *
+sched_edf_get_task(sched_t *sched)
+{
+        DECL_PTRS(sched, lo);
+
+        // 到达释放时间的任务按绝对截止期入堆
+        list_head_t *released = &lo->algo_ctx.edf.released;
+        twheel_advance(&lo->algo_ctx.edf.tw, lo->curr_ts, released);
+        while (!list_empty(released)) {
+                twheel_node_t *tw_node    = CONTAINER_OF(released->next, twheel_node_t, node);
+                sched_task_t  *task       = CONTAINER_OF(tw_node, sched_task_t, tw_node);
+                task->status.abs_deadline = task->status.next_exec_ts + sched_task_deadline(sched, &task->cfg);
+                list_del(&tw_node->node);
+                dheap_push(&lo->algo_ctx.edf.ready, &task->dh_node, sched_edf_key(task));
+        }
+
+        dheap_node_t *dh_node = dheap_top(&lo->algo_ctx.edf.ready);
+        if (!dh_node)
+                return NULL;
+        return CONTAINER_OF(dh_node, sched_task_t, dh_node);
+}
+
+HAPI sched_task_t *
+sched_fcfs_get_task(sched_t *sched)
+{
+        DECL_PTRS(sched, cfg, lo);
+
         usz prev_idx = lo->algo_ctx.fcfs.prev_idx;
         for (usz i = 0; i < lo->task_num; ++i) {
                 usz           idx = (prev_idx + i) % lo->task_num;
-                sched_task_t *t   = &lo->tasks[idx];
+                sched_task_t *t   = &cfg->tasks[idx];
                 if (t->status.e_state == SCHED_TASK_STATE_RUNNING) {
                         lo->algo_ctx.fcfs.prev_idx = idx + 1;
                         return t;
@@ -204,30 +449,401 @@ sched_fcfs_get_task(sched_t *sched)
         return NULL;
 }
 
+/*
+ * 任务在运行或休眠, 尚未挂起或结束. 休眠时 next_exec_ts 为唤醒超时而不是释放时刻,
+ * 未设超时时为 SCHED_WAKE_NEVER, 不在调度结构中, 也不会到期.
+ */
+HAPI bool
+sched_task_armed(const sched_task_t *task)
+{
+        return task->status.e_state == SCHED_TASK_STATE_RUNNING || task->status.e_state == SCHED_TASK_STATE_SLEEPING;
+}
+
+/* 本轮的执行顺序: EDF 按截止期, 其它按 priority, 相同时先释放的在前 */
+HAPI bool
+sched_due_before(sched_t *sched, const sched_task_t *a, const sched_task_t *b)
+{
+        DECL_PTRS(sched, cfg);
+
+        if (cfg->e_type == SCHED_TYPE_EDF)
+                return sched_edf_key(a) < sched_edf_key(b);
+        if (a->cfg.priority != b->cfg.priority)
+                return a->cfg.priority < b->cfg.priority;
+        return a->status.next_exec_ts < b->status.next_exec_ts;
+}
+
+/* 从尾部向前插入, 同序的任务保持到期顺序 */
+HAPI void
+sched_due_insert(sched_t *sched, sched_task_t *task)
+{
+        DECL_PTRS(sched, lo);
+
+        list_head_t *pos;
+        LIST_FOR_EACH_PREV(pos, &lo->due)
+        {
+                if (!sched_due_before(sched, task, CONTAINER_OF(pos, sched_task_t, due_node)))
+                        break;
+        }
+        __list_add(&task->due_node, pos, pos->next);
+}
+
+HAPI void
+sched_due_del(sched_task_t *task)
+{
+        if (!list_empty(&task->due_node)) {
+                list_del(&task->due_node);
+                list_init(&task->due_node);
+        }
+}
+
+/* 将所有到期任务从调度结构中摘下, 按执行顺序放入 due 链表 */
+HAPI void
+sched_due_collect(sched_t *sched)
+{
+        DECL_PTRS(sched, cfg, lo);
+
+        // FCFS 不维护调度结构, 直接扫描任务数组
+        if (cfg->e_type == SCHED_TYPE_FCFS) {
+                for (usz i = 0; i < lo->task_num; i++) {
+                        sched_task_t *task = &cfg->tasks[i];
+                        if (sched_task_armed(task) && task->status.next_exec_ts <= lo->curr_ts)
+                                sched_due_insert(sched, task);
+                }
+                return;
+        }
+
+        sched_task_t *task;
+        while ((task = lo->f_get_task(sched)) && task->status.next_exec_ts <= lo->curr_ts) {
+                lo->f_remove_task(sched, task);
+                sched_due_insert(sched, task);
+        }
+}
+
+/*
+ * 任务数组未满时追加, 否则复用已结束的任务.
+ * 回调中移除自身后该位置仍被 sched_dispatch 使用, 回调返回前不复用.
+ */
+HAPI sched_task_t *
+sched_task_slot(sched_t *sched)
+{
+        DECL_PTRS(sched, cfg, lo);
+
+        if (lo->task_num < cfg->task_max)
+                return &cfg->tasks[lo->task_num++];
+        for (usz i = 0; i < lo->task_num; i++) {
+                sched_task_t *task = &cfg->tasks[i];
+                if (task->status.e_state == SCHED_TASK_STATE_DEAD && task != lo->running)
+                        return task;
+        }
+        return NULL;
+}
+
+/* 按 ID 查找未结束的任务 */
+HAPI sched_task_t *
+sched_task_find(sched_t *sched, const usz id)
+{
+        DECL_PTRS(sched, cfg, lo);
+
+        for (usz i = 0; i < lo->task_num; i++) {
+                sched_task_t *task = &cfg->tasks[i];
+                if (task->status.e_state != SCHED_TASK_STATE_DEAD && task->cfg.id == id)
+                        return task;
+        }
+        return NULL;
+}
+
+/**
+ * @brief 添加任务
+ *
+ * 只能在 sched_start 之前或在调度线程内 (任务回调中) 调用, 其它线程使用 sched_cmd_post.
+ *
+ * @param sched
+ * @param task_cfg
+ * @return 0 成功, -MEALLOC 任务数组已满, -MEBUSY EDF 准入失败, -MEINVAL 没有回调或虚拟时间模式下频率为 0
+ */
 HAPI int
 sched_add_task(sched_t *sched, sched_task_cfg_t task_cfg)
 {
         DECL_PTRS(sched, cfg, lo);
 
-        sched_task_t *task        = &lo->tasks[lo->task_num];
+        // 虚拟时间下回调不耗时, 周期为 0 的任务会在同一时刻无限执行
+        if (!task_cfg.f_cb || (cfg->virt && !task_cfg.exec_freq))
+                return -MEINVAL;
+
+        // EDF 准入控制: 总利用率不超过 1
+        const bool edf  = (cfg->e_type == SCHED_TYPE_EDF);
+        const f64  util = edf ? sched_task_util(sched, &task_cfg) : 0;
+        if (edf && lo->algo_ctx.edf.util + util > 1.0)
+                return -MEBUSY;
+
+        sched_task_t *task = sched_task_slot(sched);
+        if (!task)
+                return -MEALLOC;
+        if (edf)
+                lo->algo_ctx.edf.util += util;
+
+        memset(task, 0, sizeof(sched_task_t));
+        list_init(&task->due_node);
+        twheel_node_init(&task->tw_node);
+        dheap_node_init(&task->dh_node);
         task->cfg                 = task_cfg;
         task->status.e_state      = SCHED_TASK_STATE_RUNNING;
-        task->status.create_ts    = cfg->f_get_ts();
-        task->status.next_exec_ts = task->status.create_ts + task->cfg.delay_tick;
+        task->status.create_ts    = sched_now(sched);
+        task->status.phase_ts     = task->status.create_ts + task->cfg.delay_tick;
+        task->status.next_exec_ts = task->status.phase_ts;
+
+        if (lo->f_insert_task)
+                lo->f_insert_task(sched, task);
+
+        // 新位置初始化完成后才对快照可见
+        ATOMIC_STORE_EXPLICIT(&lo->stats.task_num, lo->task_num, memory_order_release);
+        return 0;
+}
+
+/**
+ * @brief 移除任务, 调用限制同 sched_add_task
+ *
+ * @param sched
+ * @param id
+ * @return 0 成功, -MEINVAL 任务不存在
+ */
+HAPI int
+sched_remove_task(sched_t *sched, const usz id)
+{
+        DECL_PTRS(sched, cfg, lo);
+
+        sched_task_t *task = sched_task_find(sched, id);
+        if (!task)
+                return -MEINVAL;
+
+        if (sched_task_armed(task) && lo->f_remove_task)
+                lo->f_remove_task(sched, task);
+        sched_due_del(task);
+        if (cfg->e_type == SCHED_TYPE_EDF)
+                lo->algo_ctx.edf.util -= sched_task_util(sched, &task->cfg);
+        task->status.e_state = SCHED_TASK_STATE_DEAD;
+        return 0;
+}
+
+/**
+ * @brief 挂起任务, 调用限制同 sched_add_task
+ *
+ * @param sched
+ * @param id
+ * @return 0 成功, -MEINVAL 任务不存在或未运行
+ */
+HAPI int
+sched_pause_task(sched_t *sched, const usz id)
+{
+        DECL_PTRS(sched, lo);
+
+        sched_task_t *task = sched_task_find(sched, id);
+        if (!task || task->status.e_state != SCHED_TASK_STATE_RUNNING)
+                return -MEINVAL;
+
+        if (lo->f_remove_task)
+                lo->f_remove_task(sched, task);
+        sched_due_del(task);
+        task->status.e_state = SCHED_TASK_STATE_STOPPED;
+        return 0;
+}
+
+/**
+ * @brief 恢复挂起的任务, 挂起期间错过的释放合并为一次立即执行, 并以此为新的相位. 调用限制同 sched_add_task
+ *
+ * @param sched
+ * @param id
+ * @return 0 成功, -MEINVAL 任务不存在或未挂起
+ */
+HAPI int
+sched_resume_task(sched_t *sched, const usz id)
+{
+        DECL_PTRS(sched, cfg, lo);
+
+        sched_task_t *task = sched_task_find(sched, id);
+        if (!task || task->status.e_state != SCHED_TASK_STATE_STOPPED)
+                return -MEINVAL;
+
+        task->status.next_exec_ts = MAX(task->status.next_exec_ts, (usz)sched_now(sched));
+        task->status.phase_ts     = task->status.next_exec_ts;
+        task->status.release_cnt  = 0;
+        task->status.e_state      = SCHED_TASK_STATE_RUNNING;
+        if (lo->f_insert_task)
+                lo->f_insert_task(sched, task);
+        return 0;
+}
+
+/**
+ * @brief 修改执行频率, 已排定的下一次释放不变并作为新的相位. 调用限制同 sched_add_task
+ *
+ * 休眠中的任务以最近一次释放为新的相位, 唤醒后按新频率从该相位继续.
+ *
+ * @param sched
+ * @param id
+ * @param exec_freq
+ * @return 0 成功, -MEINVAL 任务不存在或频率为 0, -MEBUSY EDF 准入失败
+ */
+HAPI int
+sched_retune_task(sched_t *sched, const usz id, const usz exec_freq)
+{
+        DECL_PTRS(sched, cfg, lo);
+
+        sched_task_t *task = sched_task_find(sched, id);
+        if (!task || !exec_freq)
+                return -MEINVAL;
+
+        // 休眠中的 next_exec_ts 是唤醒超时, 以原频率下第 release_cnt 次释放为新的相位, 唤醒后由此继续
+        const usz phase_ts = (task->status.e_state == SCHED_TASK_STATE_SLEEPING)
+                                 ? (usz)sched_task_release(sched, task, task->status.release_cnt)
+                                 : task->status.next_exec_ts;
+
+        sched_task_cfg_t task_cfg = task->cfg;
+        task_cfg.exec_freq        = exec_freq;
+        if (cfg->e_type == SCHED_TYPE_EDF) {
+                const f64 util = lo->algo_ctx.edf.util - sched_task_util(sched, &task->cfg) +
+                                 sched_task_util(sched, &task_cfg);
+                if (util > 1.0)
+                        return -MEBUSY;
+                lo->algo_ctx.edf.util = util;
+        }
+        task->cfg                = task_cfg;
+        task->status.phase_ts    = phase_ts;
+        task->status.release_cnt = 0;
+        return 0;
+}
+
+/**
+ * @brief 任务进入休眠, 停止周期释放, 直到 sched_task_wake 或到达 wake_ts. 调用限制同 sched_add_task
+ *
+ * 可以在任务自身的回调中调用. 唤醒后执行一次, 之后从原相位继续周期释放, 休眠期间错过的释放按 e_overrun 处理.
+ *
+ * @param sched
+ * @param task
+ * @param wake_ts 超时时刻, SCHED_WAKE_NEVER 不超时
+ * @return 0 成功, -MEINVAL 任务未运行
+ */
+HAPI int
+sched_task_sleep(sched_t *sched, sched_task_t *task, const usz wake_ts)
+{
+        DECL_PTRS(sched, lo);
 
-        lo->task_num++;
-        if (sched->cfg.e_type == SCHED_TYPE_CFS)
+        if (!sched_task_armed(task))
+                return -MEINVAL;
+
+        if (lo->f_remove_task)
+                lo->f_remove_task(sched, task);
+        sched_due_del(task);
+        task->status.e_state      = SCHED_TASK_STATE_SLEEPING;
+        task->status.next_exec_ts = wake_ts;
+        if (wake_ts != SCHED_WAKE_NEVER && lo->f_insert_task)
                 lo->f_insert_task(sched, task);
+        return 0;
+}
+
+/**
+ * @brief 唤醒休眠的任务, 在下一轮 sched_exec 执行. 调用限制同 sched_add_task, 可在网络回调中调用
+ *
+ * @param sched
+ * @param task
+ * @return 0 成功, -MEINVAL 任务未休眠
+ */
+HAPI int
+sched_task_wake(sched_t *sched, sched_task_t *task)
+{
+        DECL_PTRS(sched, lo);
 
+        if (task->status.e_state != SCHED_TASK_STATE_SLEEPING)
+                return -MEINVAL;
+
+        if (lo->f_remove_task)
+                lo->f_remove_task(sched, task);
+        sched_due_del(task);
+        task->status.e_state      = SCHED_TASK_STATE_RUNNING;
+        task->status.next_exec_ts = sched_now(sched);
+        if (lo->f_insert_task)
+                lo->f_insert_task(sched, task);
         return 0;
 }
 
+/**
+ * @brief 投递命令, 任意线程可调用, 调度线程在下一次 sched_exec 开始时执行
+ *
+ * 执行结果计入 sched_stats_t 的 cmd_cnt / cmd_fail_cnt.
+ *
+ * @param sched
+ * @param cmd
+ * @return 0 成功, -MEINVAL 未配置命令队列, -MEAGAIN 队列已满
+ */
+HAPI int
+sched_cmd_post(sched_t *sched, sched_cmd_t cmd)
+{
+        DECL_PTRS(sched, cfg, lo);
+
+        if (!cfg->cmd_buf)
+                return -MEINVAL;
+        return mpmc_push(&lo->cmd, &cmd) ? 0 : -MEAGAIN;
+}
+
+HAPI int
+sched_cmd_exec(sched_t *sched, const sched_cmd_t *cmd)
+{
+        switch (cmd->e_cmd) {
+                case SCHED_CMD_ADD:
+                        return sched_add_task(sched, cmd->task_cfg);
+                case SCHED_CMD_REMOVE:
+                        return sched_remove_task(sched, cmd->task_cfg.id);
+                case SCHED_CMD_PAUSE:
+                        return sched_pause_task(sched, cmd->task_cfg.id);
+                case SCHED_CMD_RESUME:
+                        return sched_resume_task(sched, cmd->task_cfg.id);
+                case SCHED_CMD_RETUNE:
+                        return sched_retune_task(sched, cmd->task_cfg.id, cmd->task_cfg.exec_freq);
+                default:
+                        return -MEINVAL;
+        }
+}
+
+/* 执行队列中的命令, 每次最多 cmd_cap 条, 避免持续投递时饿死任务 */
+HAPI void
+sched_cmd_apply(sched_t *sched)
+{
+        DECL_PTRS(sched, cfg, lo);
+
+        if (!cfg->cmd_buf)
+                return;
+
+        sched_cmd_t cmd;
+        for (usz i = 0; i < cfg->cmd_cap && mpmc_pop(&lo->cmd, &cmd); i++) {
+                const int ret = sched_cmd_exec(sched, &cmd);
+                sched_stat_add(&lo->stats.cmd_cnt, 1);
+                if (ret < 0)
+                        sched_stat_add(&lo->stats.cmd_fail_cnt, 1);
+        }
+}
+
+/**
+ * @brief 初始化调度器, 不创建调度线程
+ *
+ * 之后添加初始任务, 再以 sched_start 启动调度线程; cpu_id 为 SCHED_CPU_NONE 或虚拟时间模式时由调用者驱动.
+ *
+ * @param sched
+ * @param sched_cfg
+ * @return 0 成功, -MEINVAL 配置无效
+ */
 HAPI int
 sched_init(sched_t *sched, sched_cfg_t sched_cfg)
 {
         DECL_PTRS(sched, cfg, lo);
 
+        if (!sched_cfg.tasks || !sched_cfg.task_max)
+                return -MEINVAL;
+
         *cfg = sched_cfg;
+        memset(lo, 0, sizeof(sched_lo_t));
+        list_init(&lo->due);
+        lo->stats.start_ts = sched_now(sched);
+        if (cfg->cmd_buf && mpmc_init(&lo->cmd, cfg->cmd_buf, cfg->cmd_cap, sizeof(sched_cmd_t)) < 0)
+                return -MEINVAL;
 
         switch (cfg->e_type) {
                 case SCHED_TYPE_FCFS: {
@@ -242,49 +858,359 @@ sched_init(sched_t *sched, sched_cfg_t sched_cfg)
                         lo->f_remove_task = sched_cfs_remove_task;
                         break;
                 }
+                case SCHED_TYPE_WHEEL: {
+                        lo->f_get_task    = sched_wheel_get_task;
+                        lo->f_insert_task = sched_wheel_insert_task;
+                        lo->f_remove_task = sched_wheel_remove_task;
+                        twheel_init(&lo->algo_ctx.wheel.tw, sched_now(sched));
+                        list_init(&lo->algo_ctx.wheel.ready);
+                        break;
+                }
+                case SCHED_TYPE_EDF: {
+                        if (!cfg->heap_buf)
+                                return -MEINVAL;
+                        lo->f_get_task    = sched_edf_get_task;
+                        lo->f_insert_task = sched_edf_insert_task;
+                        lo->f_remove_task = sched_edf_remove_task;
+                        twheel_init(&lo->algo_ctx.edf.tw, sched_now(sched));
+                        list_init(&lo->algo_ctx.edf.released);
+                        dheap_init(&lo->algo_ctx.edf.ready, cfg->heap_buf, cfg->task_max);
+                        break;
+                }
                 default:
                         return -MEINVAL;
         }
-
-        // only run on Linux/Windows
-        sched_thread_init(sched, cfg->cpu_id);
         return 0;
 }
 
+/**
+ * @brief 创建调度线程, 线程完成绑核与实时设置 (包括抖动自测) 后返回
+ *
+ * 之后其它线程只能经 sched_cmd_post 修改任务. 只在 Linux/Windows 上创建线程.
+ *
+ * @param sched
+ * @return 0 成功, -MEINVAL cpu_id 为 SCHED_CPU_NONE 或虚拟时间模式, -MECREATE 创建线程失败
+ */
 HAPI int
-sched_exec(sched_t *sched)
+sched_start(sched_t *sched)
 {
-        DECL_PTRS(sched, cfg, lo);
-
-        lo->curr_ts = cfg->f_get_ts();
+        DECL_PTRS(sched, cfg);
 
-        sched_task_t *task = lo->f_get_task(sched);
-        if (!task || !task->cfg.f_cb)
+        if (cfg->virt || cfg->cpu_id == SCHED_CPU_NONE)
                 return -MEINVAL;
+        return sched_thread_init(sched, cfg->cpu_id, &cfg->rt);
+}
 
-        if (lo->curr_ts - task->status.create_ts < task->cfg.delay_tick)
-                return 0;
+/* 第 release_cnt 次释放已在 end_ts 之前, 跳到不早于 end_ts 的第一个释放 */
+HAPI u64
+sched_task_skip(sched_t *sched, sched_task_t *task, const u64 end_ts)
+{
+        sched_task_status_t *status = &task->status;
 
-        if (lo->curr_ts < task->status.next_exec_ts)
-                return 0;
+        const u64 tps = sched_tick_per_sec(sched);
+        const u64 k   = ((end_ts - status->phase_ts) * task->cfg.exec_freq + tps - 1) / tps;
+        sched_stat_add(&task->stats.skip_cnt, k - status->release_cnt);
+        status->release_cnt = k;
+        return sched_task_release(sched, task, k);
+}
 
-        if (sched->cfg.e_type == SCHED_TYPE_CFS)
-                sched_cfs_remove_task(sched, task);
+/* 计算下一次释放时刻, 执行结束时已错过下一次释放则按 e_overrun 处理 */
+HAPI void
+sched_task_rearm(sched_t *sched, sched_task_t *task, const u64 end_ts)
+{
+        sched_task_status_t *status = &task->status;
 
-        const u64 begin_ts = lo->curr_ts;
+        // 周期为 0 的任务每轮执行一次
+        if (!task->cfg.exec_freq) {
+                status->next_exec_ts = end_ts;
+                return;
+        }
+
+        status->release_cnt++;
+        u64 next = sched_task_release(sched, task, status->release_cnt);
+        if (next >= end_ts) {
+                status->burst        = 0;
+                status->next_exec_ts = next;
+                return;
+        }
+
+        switch (task->cfg.e_overrun) {
+                case SCHED_OVERRUN_CATCHUP: {
+                        if (!task->cfg.burst_max || status->burst < task->cfg.burst_max) {
+                                status->burst++;
+                                break;
+                        }
+                        status->burst = 0;
+                        next          = sched_task_skip(sched, task, end_ts);
+                        break;
+                }
+                case SCHED_OVERRUN_REPHASE: {
+                        status->phase_ts    = end_ts;
+                        status->release_cnt = 1;
+                        next                = sched_task_release(sched, task, 1);
+                        break;
+                }
+                case SCHED_OVERRUN_SKIP:
+                default: {
+                        next = sched_task_skip(sched, task, end_ts);
+                        break;
+                }
+        }
+        status->next_exec_ts = next;
+}
+
+HAPI void
+sched_dispatch(sched_t *sched, sched_task_t *task)
+{
+        DECL_PTRS(sched, cfg, lo);
+
+        task->status.e_state      = SCHED_TASK_STATE_RUNNING; // 休眠超时
+        task->status.abs_deadline = task->status.next_exec_ts + sched_task_deadline(sched, &task->cfg);
+
+        const u64 begin_ts = sched_now(sched);
+        lo->running        = task;
         task->cfg.f_cb(task->cfg.arg);
-        const u64 end_ts = cfg->f_get_ts();
+        lo->running      = NULL;
+        const u64 end_ts = sched_now(sched);
+
+        const u64 period = sched_task_period(sched, &task->cfg);
+        const u64 jitter = begin_ts - task->status.next_exec_ts;
+        const u64 exec   = end_ts - begin_ts;
 
         task->status.exec_cnt++;
-        task->status.elapsed_us = (f32)(end_ts - begin_ts);
+        task->status.elapsed_us = (f32)exec;
+        if (end_ts > task->status.abs_deadline) {
+                task->status.miss_cnt++;
+                sched_stat_add(&task->stats.miss_cnt, 1);
+        }
+        if (period && exec > period)
+                sched_stat_add(&task->stats.overrun_cnt, 1);
+        sched_stat_add(&task->stats.exec_cnt, 1);
+        sched_hist_record(&task->stats.jitter, jitter);
+        sched_hist_record(&task->stats.exec, exec);
+        sched_stat_add(&lo->stats.busy, exec);
+        sched_stat_add(&lo->stats.dispatch_cnt, 1);
+
+        // 回调中挂起, 移除了自身或进入休眠
+        if (task->status.e_state != SCHED_TASK_STATE_RUNNING)
+                return;
 
         if (task->cfg.exec_cnt_max == 0 || task->status.exec_cnt < task->cfg.exec_cnt_max) {
-                task->status.next_exec_ts = end_ts + sched_hz2tick(sched, (f32)task->cfg.exec_freq);
-                if (sched->cfg.e_type == SCHED_TYPE_CFS)
-                        sched_cfs_insert_task(sched, task);
-        } else
+                sched_task_rearm(sched, task, end_ts);
+                if (lo->f_insert_task)
+                        lo->f_insert_task(sched, task);
+        } else {
                 task->status.e_state = SCHED_TASK_STATE_DEAD;
+                if (cfg->e_type == SCHED_TYPE_EDF)
+                        lo->algo_ctx.edf.util -= sched_task_util(sched, &task->cfg);
+        }
+}
+
+/**
+ * @brief 调度一轮: 执行命令, 再按优先级依次执行本轮开始时所有到期的任务
+ *
+ * 执行期间新到期的任务留到下一轮. 回调中挂起或移除本轮尚未执行的任务, 该任务不再执行.
+ *
+ * @param sched
+ * @return 本轮执行的任务数
+ */
+HAPI int
+sched_exec(sched_t *sched)
+{
+        DECL_PTRS(sched, lo);
 
+        lo->curr_ts = sched_now(sched);
+        sched_cmd_apply(sched);
+        sched_due_collect(sched);
+
+        int cnt = 0;
+        while (!list_empty(&lo->due)) {
+                sched_task_t *task = LIST_FIRST_ENTRY(&lo->due, sched_task_t, due_node);
+                sched_due_del(task);
+                sched_dispatch(sched, task);
+                cnt++;
+        }
+        return cnt;
+}
+
+/**
+ * @brief 读取任务统计快照, 任意线程可调用
+ *
+ * @param task
+ * @param stats
+ */
+HAPI void
+sched_task_stats_snapshot(const sched_task_t *task, sched_task_stats_t *stats)
+{
+        stats->id          = task->cfg.id;
+        stats->exec_cnt    = sched_stat_load(&task->stats.exec_cnt);
+        stats->overrun_cnt = sched_stat_load(&task->stats.overrun_cnt);
+        stats->miss_cnt    = sched_stat_load(&task->stats.miss_cnt);
+        stats->skip_cnt    = sched_stat_load(&task->stats.skip_cnt);
+        sched_hist_snapshot(&task->stats.jitter, &stats->jitter);
+        sched_hist_snapshot(&task->stats.exec, &stats->exec);
+}
+
+/**
+ * @brief 读取调度器统计快照, 任意线程可调用
+ *
+ * @param sched
+ * @param stats
+ */
+HAPI void
+sched_stats_snapshot(sched_t *sched, sched_stats_t *stats)
+{
+        DECL_PTRS(sched, cfg, lo);
+
+        stats->cpu_id       = cfg->cpu_id;
+        stats->task_num     = (usz)ATOMIC_LOAD_EXPLICIT(&lo->stats.task_num, memory_order_acquire);
+        stats->ts           = sched_now(sched);
+        stats->elapsed      = stats->ts - lo->stats.start_ts;
+        stats->busy         = sched_stat_load(&lo->stats.busy);
+        stats->util         = stats->elapsed ? (f64)stats->busy / (f64)stats->elapsed : 0;
+        stats->dispatch_cnt = sched_stat_load(&lo->stats.dispatch_cnt);
+        stats->cmd_cnt      = sched_stat_load(&lo->stats.cmd_cnt);
+        stats->cmd_fail_cnt = sched_stat_load(&lo->stats.cmd_fail_cnt);
+}
+
+/**
+ * @brief 最早的释放时刻, 对时间轮类调度器为下界
+ *
+ * @param sched
+ * @return 没有任务时返回 UINT64_MAX
+ */
+HAPI u64
+sched_next_ts(sched_t *sched)
+{
+        DECL_PTRS(sched, cfg, lo);
+
+        switch (cfg->e_type) {
+                case SCHED_TYPE_FCFS: {
+                        u64 next = UINT64_MAX;
+                        for (usz i = 0; i < lo->task_num; i++) {
+                                const sched_task_t *task = &cfg->tasks[i];
+                                if (sched_task_armed(task))
+                                        next = MIN(next, (u64)task->status.next_exec_ts);
+                        }
+                        return next;
+                }
+                case SCHED_TYPE_CFS: {
+                        const sched_task_t *task = sched_cfs_get_task(sched);
+                        return task ? task->status.next_exec_ts : UINT64_MAX;
+                }
+                case SCHED_TYPE_WHEEL: {
+                        if (!list_empty(&lo->algo_ctx.wheel.ready))
+                                return lo->curr_ts;
+                        return twheel_next(&lo->algo_ctx.wheel.tw);
+                }
+                case SCHED_TYPE_EDF: {
+                        if (dheap_top(&lo->algo_ctx.edf.ready))
+                                return lo->curr_ts;
+                        return twheel_next(&lo->algo_ctx.edf.tw);
+                }
+                default:
+                        return 0;
+        }
+}
+
+/**
+ * @brief 按 e_idle 等待到下一次释放时刻
+ *
+ * SCHED_IDLE_SLEEP 先以 CLOCK_MONOTONIC 绝对时间休眠到释放前 spin_window, 再自旋到释放时刻,
+ * 用少量自旋吸收内核唤醒延迟. 其它平台退化为自旋.
+ *
+ * @param sched
+ */
+HAPI void
+sched_idle(sched_t *sched)
+{
+        DECL_PTRS(sched, cfg, lo);
+
+        if (cfg->virt || cfg->e_idle != SCHED_IDLE_SLEEP)
+                return;
+
+        const u64 next = sched_next_ts(sched);
+        const u64 now  = sched_now(sched);
+        if (next <= now)
+                return;
+
+        u64 sleep_ns = (next == UINT64_MAX) ? SCHED_IDLE_SLEEP_MAX_NS : sched_tick2ns(sched, next - now);
+        sleep_ns     = MIN(sleep_ns, SCHED_IDLE_SLEEP_MAX_NS);
+
+#ifdef __linux__
+        const u64 window_ns = sched_tick2ns(sched, cfg->spin_window);
+        if (sleep_ns > window_ns) {
+                struct timespec ts;
+                clock_gettime(CLOCK_MONOTONIC, &ts);
+                const u64 wake_ns = (u64)ts.tv_sec * NANO_PER_SEC + (u64)ts.tv_nsec + sleep_ns - window_ns;
+
+                ts.tv_sec  = (time_t)(wake_ns / NANO_PER_SEC);
+                ts.tv_nsec = (long)(wake_ns % NANO_PER_SEC);
+                while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+                        ; // 被信号打断时继续休眠到同一绝对时刻
+
+                clock_gettime(CLOCK_MONOTONIC, &ts);
+                const u64 woke_ns = (u64)ts.tv_sec * NANO_PER_SEC + (u64)ts.tv_nsec;
+                const u64 lat_ns  = (woke_ns > wake_ns) ? woke_ns - wake_ns : 0;
+
+                lo->idle.sleep_cnt++;
+                lo->idle.wake_lat_ns_sum += lat_ns;
+                lo->idle.wake_lat_ns_max  = MAX(lo->idle.wake_lat_ns_max, lat_ns);
+        }
+#endif
+
+        if (next == UINT64_MAX)
+                return;
+
+        // 自旋窗口: 只读时钟, 不做调度
+        if (sched_now(sched) > next) {
+                lo->idle.late_cnt++;
+                return;
+        }
+        while (sched_now(sched) < next)
+                CPU_RELAX();
+}
+
+/**
+ * @brief 调度线程的一次循环: 执行到期任务, 没有任务执行时按空闲策略等待
+ *
+ * @param sched
+ */
+HAPI void
+sched_poll(sched_t *sched)
+{
+        sched_exec(sched);
+        sched_idle(sched);
+}
+
+/**
+ * @brief 虚拟时间模式下运行到 t_end
+ *
+ * 不逐 tick 轮询, 虚拟时钟直接跳到下一次释放时刻, 执行该时刻所有到期的任务, 直到下一次释放晚于 t_end.
+ * 返回时虚拟时钟不早于 t_end. 回调中用 sched_consume 模拟执行时间.
+ *
+ * @param sched
+ * @param t_end
+ * @return 0 成功, -MEINVAL 不是虚拟时间模式
+ */
+HAPI int
+sched_run_until(sched_t *sched, const u64 t_end)
+{
+        DECL_PTRS(sched, cfg, lo);
+
+        if (!cfg->virt)
+                return -MEINVAL;
+
+        sched_cmd_apply(sched);
+        for (;;) {
+                // 时间轮给出的是下界, 跳到下界后推进时间轮, 无任务到期时再取下一个下界
+                const u64 next = sched_next_ts(sched);
+                if (next > t_end)
+                        break;
+                ATOMIC_STORE_EXPLICIT(&lo->virt_ts, MAX(sched_now(sched), next), memory_order_relaxed);
+                sched_exec(sched);
+        }
+        ATOMIC_STORE_EXPLICIT(&lo->virt_ts, MAX(sched_now(sched), t_end), memory_order_relaxed);
         return 0;
 }
 
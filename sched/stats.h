@@ -0,0 +1,206 @@
+#ifndef SCHED_STATS_H
+#define SCHED_STATS_H
+
+#include <string.h>
+
+#include "../util/bitops.h"
+#include "../util/macrodef.h"
+#include "../util/mathdef.h"
+#include "../util/typedef.h"
+
+/*
+ * 调度统计: 对数线性直方图与计数器.
+ * 调度线程是唯一写者, 以 relaxed 读改写更新, 不使用带锁前缀的原子加;
+ * 其它线程随时可无锁读取快照.
+ * 快照中各字段分别原子, 字段之间不保证是同一时刻的值.
+ *
+ * 直方图按 tick 计数: 小于 2^SCHED_HIST_SUB_BITS 的值各占一格, 之后每个 2 的幂区间
+ * 再均分为 2^SCHED_HIST_SUB_BITS 格, 相对误差不超过 1 / 2^SCHED_HIST_SUB_BITS.
+ */
+#define SCHED_HIST_SUB_BITS (2)
+#define SCHED_HIST_SUB_NUM  (1U << SCHED_HIST_SUB_BITS)
+#define SCHED_HIST_NUM      (24U << SCHED_HIST_SUB_BITS) // 覆盖 [0, 2^25) tick, 更大的值计入最后一格
+
+/* 直方图快照, 纯数据结构, 可直接写入 shm 发布 */
+typedef struct {
+        u64 cnt[SCHED_HIST_NUM]; // 各格计数
+        u64 num;                 // 样本数
+        u64 sum;                 // 样本和
+        u64 max;                 // 最大样本
+} sched_hist_t;
+
+typedef struct {
+        ATOMIC(u64) cnt[SCHED_HIST_NUM];
+        ATOMIC(u64) num;
+        ATOMIC(u64) sum;
+        ATOMIC(u64) max;
+} sched_hist_counter_t;
+
+/* 任务统计快照 */
+typedef struct {
+        usz          id;          // 任务 ID
+        u64          exec_cnt;    // 执行次数
+        u64          overrun_cnt; // 执行时间超过周期的次数
+        u64          miss_cnt;    // 错过截止期的次数
+        u64          skip_cnt;    // 因超时跳过的释放次数
+        sched_hist_t jitter;      // 释放抖动: 实际开始 - 计划释放 (tick)
+        sched_hist_t exec;        // 执行时间 (tick)
+} sched_task_stats_t;
+
+typedef struct {
+        ATOMIC(u64) exec_cnt;
+        ATOMIC(u64) overrun_cnt;
+        ATOMIC(u64) miss_cnt;
+        ATOMIC(u64) skip_cnt;
+        sched_hist_counter_t jitter;
+        sched_hist_counter_t exec;
+} sched_task_counter_t;
+
+/* 调度器统计快照 */
+typedef struct {
+        u8  cpu_id;       // 调度线程所在 CPU
+        usz task_num;     // 任务数
+        u64 ts;           // 快照时刻 (tick)
+        u64 elapsed;      // 自 sched_init 起经过的 tick
+        u64 busy;         // 其中执行回调的 tick
+        f64 util;         // CPU 利用率, busy / elapsed
+        u64 dispatch_cnt; // 回调执行总次数
+        u64 cmd_cnt;      // 已执行的命令数
+        u64 cmd_fail_cnt; // 其中失败的命令数
+} sched_stats_t;
+
+typedef struct {
+        u64 start_ts; // sched_init 时刻
+        ATOMIC(u64) task_num; // 已使用的任务数组长度, 任务初始化完成后以 release 发布
+        ATOMIC(u64) busy;
+        ATOMIC(u64) dispatch_cnt;
+        ATOMIC(u64) cmd_cnt;
+        ATOMIC(u64) cmd_fail_cnt;
+} sched_counter_t;
+
+/* -------------------------------------------------------------------------- */
+/*                                   声明                                     */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief 样本所在的格
+ *
+ * @param v
+ * @return u32
+ */
+HAPI u32 sched_hist_bucket(u64 v);
+
+/**
+ * @brief 第 idx 格的下界 (包含)
+ *
+ * @param idx
+ * @return u64
+ */
+HAPI u64 sched_hist_bucket_low(u32 idx);
+
+/**
+ * @brief 记录一个样本, 仅限唯一写者调用
+ *
+ * @param hist
+ * @param v
+ */
+HAPI void sched_hist_record(sched_hist_counter_t *hist, u64 v);
+
+/**
+ * @brief 读取直方图快照, 任意线程可调用
+ *
+ * @param hist
+ * @param snap
+ */
+HAPI void sched_hist_snapshot(const sched_hist_counter_t *hist, sched_hist_t *snap);
+
+/**
+ * @brief 分位数的近似值, 返回所在格的上界, 不超过最大样本
+ *
+ * @param hist
+ * @param q 0~1
+ * @return 没有样本时返回 0
+ */
+HAPI u64 sched_hist_quantile(const sched_hist_t *hist, f64 q);
+
+/* -------------------------------------------------------------------------- */
+/*                                   定义                                     */
+/* -------------------------------------------------------------------------- */
+
+/* 唯一写者累加, 普通读写即可, 原子类型只为读者不产生数据竞争 */
+HAPI void
+sched_stat_add(ATOMIC(u64) *counter, const u64 n)
+{
+        ATOMIC_STORE_EXPLICIT(counter, ATOMIC_LOAD_EXPLICIT(counter, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+HAPI u64
+sched_stat_load(const ATOMIC(u64) *counter)
+{
+        return ATOMIC_LOAD_EXPLICIT((ATOMIC(u64) *)counter, memory_order_relaxed);
+}
+
+HAPI u32
+sched_hist_bucket(const u64 v)
+{
+        if (v < SCHED_HIST_SUB_NUM)
+                return (u32)v;
+
+        const u32 exp = msb64(v);
+        const u32 sub = (u32)(v >> (exp - SCHED_HIST_SUB_BITS)) & (SCHED_HIST_SUB_NUM - 1);
+        const u32 idx = ((exp - SCHED_HIST_SUB_BITS + 1) << SCHED_HIST_SUB_BITS) | sub;
+        return MIN(idx, SCHED_HIST_NUM - 1);
+}
+
+HAPI u64
+sched_hist_bucket_low(const u32 idx)
+{
+        if (idx < SCHED_HIST_SUB_NUM)
+                return idx;
+
+        const u32 exp = (idx >> SCHED_HIST_SUB_BITS) + SCHED_HIST_SUB_BITS - 1;
+        const u64 sub = idx & (SCHED_HIST_SUB_NUM - 1);
+        return (SCHED_HIST_SUB_NUM | sub) << (exp - SCHED_HIST_SUB_BITS);
+}
+
+HAPI void
+sched_hist_record(sched_hist_counter_t *hist, const u64 v)
+{
+        sched_stat_add(&hist->cnt[sched_hist_bucket(v)], 1);
+        sched_stat_add(&hist->num, 1);
+        sched_stat_add(&hist->sum, v);
+        if (v > sched_stat_load(&hist->max))
+                ATOMIC_STORE_EXPLICIT(&hist->max, v, memory_order_relaxed);
+}
+
+HAPI void
+sched_hist_snapshot(const sched_hist_counter_t *hist, sched_hist_t *snap)
+{
+        for (usz i = 0; i < SCHED_HIST_NUM; i++)
+                snap->cnt[i] = sched_stat_load(&hist->cnt[i]);
+        snap->num = sched_stat_load(&hist->num);
+        snap->sum = sched_stat_load(&hist->sum);
+        snap->max = sched_stat_load(&hist->max);
+}
+
+HAPI u64
+sched_hist_quantile(const sched_hist_t *hist, const f64 q)
+{
+        // 各格分别读取, 以各格之和为准
+        u64 num = 0;
+        for (usz i = 0; i < SCHED_HIST_NUM; i++)
+                num += hist->cnt[i];
+        if (!num)
+                return 0;
+
+        const u64 rank = (u64)(q * (f64)(num - 1)) + 1;
+        u64       acc  = 0;
+        for (u32 i = 0; i < SCHED_HIST_NUM - 1; i++) {
+                acc += hist->cnt[i];
+                if (acc >= rank)
+                        return MIN(sched_hist_bucket_low(i + 1) - 1, hist->max);
+        }
+        return hist->max;
+}
+
+#endif // !SCHED_STATS_H
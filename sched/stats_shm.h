@@ -0,0 +1,58 @@
+#ifndef SCHED_STATS_SHM_H
+#define SCHED_STATS_SHM_H
+
+#include "../shm/shm.h"
+#include "../util/macrodef.h"
+#include "../util/typedef.h"
+
+#include "sched.h"
+#include "stats.h"
+
+/*
+ * 调度统计的 shm 发布: 调度器与各任务的统计快照以消息写入 shm, 供外部监控进程以 shm_msg_read 读取.
+ * 单独成文件, 不发布统计的调度器使用者不依赖 shm.
+ */
+
+/* shm 发布的单条消息, 每个任务一条 */
+typedef struct {
+        sched_stats_t      sched;    // 所属调度器
+        usz                task_idx; // 任务下标
+        sched_task_stats_t task;
+} sched_stats_msg_t;
+
+/* -------------------------------------------------------------------------- */
+/*                                   声明                                     */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief 将调度器与各任务的统计快照写入 shm, 每个任务一条 sched_stats_msg_t 消息
+ *
+ * 可在调度器的低频任务中调用. 任务位置被复用时, 该任务的消息可能混有新旧任务的统计.
+ *
+ * @param sched
+ * @param shm
+ * @return 写入的消息数, shm 空间不足时剩余任务不写入
+ */
+HAPI usz sched_stats_publish(sched_t *sched, shm_t *shm);
+
+/* -------------------------------------------------------------------------- */
+/*                                   定义                                     */
+/* -------------------------------------------------------------------------- */
+
+HAPI usz
+sched_stats_publish(sched_t *sched, shm_t *shm)
+{
+        DECL_PTRS(sched, cfg);
+
+        sched_stats_msg_t msg;
+        sched_stats_snapshot(sched, &msg.sched);
+        for (usz i = 0; i < msg.sched.task_num; i++) {
+                msg.task_idx = i;
+                sched_task_stats_snapshot(&cfg->tasks[i], &msg.task);
+                if (shm_msg_write(shm, &msg, sizeof(msg)) < 0)
+                        return i;
+        }
+        return msg.sched.task_num;
+}
+
+#endif // !SCHED_STATS_SHM_H
@@ -3,22 +3,77 @@
 
 #include <stdio.h>
 
+#include "../util/errdef.h"
 #include "../util/macrodef.h"
+#include "../util/mathdef.h"
+#include "../util/timeops.h"
 #include "../util/typedef.h"
 
+#define SCHED_STACK_PREFAULT_MARGIN (16 * 1024) // 预先触碰栈时在保护页之上保留的余量, 不触碰栈底
+#define SCHED_SELF_TEST_PERIOD_NS   (1000000)   // 抖动自测周期, 1 ms
+
 struct sched;
-HAPI int sched_exec(struct sched *sched);
+HAPI void sched_poll(struct sched *sched);
+
+typedef enum {
+        SCHED_RT_NONE,     // 不修改调度策略 (SCHED_OTHER)
+        SCHED_RT_FIFO,     // SCHED_FIFO, 使用 fifo_prio
+        SCHED_RT_DEADLINE, // SCHED_DEADLINE, 使用 dl_*; 内核要求亲和性覆盖整个 root domain, 需配合 cpuset
+} sched_rt_policy_e;
+
+typedef struct {
+        sched_rt_policy_e e_policy;
+        u8                fifo_prio;      // SCHED_RT_FIFO 优先级, 1~99
+        u64               dl_runtime_ns;  // SCHED_RT_DEADLINE 每周期执行预算
+        u64               dl_deadline_ns; // SCHED_RT_DEADLINE 相对截止期
+        u64               dl_period_ns;   // SCHED_RT_DEADLINE 周期
+        bool              mlock;          // 创建线程前 mlockall(MCL_CURRENT | MCL_FUTURE)
+        usz               stack_size;     // 线程栈大小, 启动时预先触碰; 0 使用默认栈且不预先触碰
+        u64               timer_slack_ns; // 线程 timer slack, 0 不修改
+        usz               self_test_cnt;  // 启动时按 1 ms 周期测量唤醒抖动的次数, 0 不测试
+} sched_rt_cfg_t;
+
+typedef struct {
+        usz cnt;    // 采样次数
+        u64 avg_ns; // 平均唤醒延迟
+        u64 max_ns; // 最大唤醒延迟
+} sched_jitter_t;
 
 #ifdef __linux__
+#include <errno.h>
 #include <pthread.h>
 #include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE (6)
+#endif
+
+typedef void *(*sched_thread_f)(void *arg);
+
+/* glibc 未提供 sched_setattr 的封装, 按内核 ABI 定义 */
+typedef struct {
+        u32 size;
+        u32 sched_policy;
+        u64 sched_flags;
+        i32 sched_nice;
+        u32 sched_priority;
+        u64 sched_runtime;
+        u64 sched_deadline;
+        u64 sched_period;
+} sched_attr_t;
 
 HAPI void *
 sched_thread_exec(void *arg)
 {
         struct sched *t = (struct sched *)arg;
         while (true)
-                sched_exec(t);
+                sched_poll(t);
         return NULL;
 }
 
@@ -33,9 +88,124 @@ sched_bind_thread_to_cpu(pthread_t thread_tid, int cpu_id)
                 printf("[SCHED]set thread affinity failed, errcode: %d\n", ret);
         printf("[SCHED]bind thread to CPU %d success\n", cpu_id);
 }
+
+/*
+ * 逐页写入当前线程栈中尚未使用的部分, 使其在进入实时循环前完成缺页.
+ * 栈的实际范围由 pthread_getattr_np 获取, 从当前栈指针所在页向下写到保护页之上 SCHED_STACK_PREFAULT_MARGIN 处,
+ * 不依赖配置的栈大小, 也不会越过保护页或 TLS.
+ */
+HAPI int
+sched_thread_prefault_stack(void)
+{
+        pthread_attr_t attr;
+        int            ret = pthread_getattr_np(pthread_self(), &attr);
+        if (ret)
+                return ret;
+
+        void  *stack_addr;
+        size_t stack_size, guard_size;
+        ret = pthread_attr_getstack(&attr, &stack_addr, &stack_size);
+        if (!ret)
+                ret = pthread_attr_getguardsize(&attr, &guard_size);
+        pthread_attr_destroy(&attr);
+        if (ret)
+                return ret;
+
+        const usz page   = (usz)sysconf(_SC_PAGESIZE);
+        const usz bottom = (usz)stack_addr + guard_size + SCHED_STACK_PREFAULT_MARGIN;
+        u8        anchor;
+        usz       addr = ((usz)&anchor & ~(page - 1)) - page;
+        for (; addr >= bottom; addr -= page)
+                *(volatile u8 *)addr = 0;
+        return 0;
+}
+
+HAPI int
+sched_thread_set_policy(const sched_rt_cfg_t *rt)
+{
+        switch (rt->e_policy) {
+                case SCHED_RT_FIFO: {
+                        const struct sched_param param = {.sched_priority = rt->fifo_prio};
+                        return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+                }
+                case SCHED_RT_DEADLINE: {
+                        sched_attr_t attr = {
+                            .size           = sizeof(sched_attr_t),
+                            .sched_policy   = SCHED_DEADLINE,
+                            .sched_runtime  = rt->dl_runtime_ns,
+                            .sched_deadline = rt->dl_deadline_ns,
+                            .sched_period   = rt->dl_period_ns,
+                        };
+                        return syscall(SYS_sched_setattr, 0, &attr, 0) ? errno : 0;
+                }
+                default:
+                        return 0;
+        }
+}
+
+/**
+ * @brief 以绝对时间周期休眠, 测量唤醒延迟
+ *
+ * @param period_ns 周期
+ * @param cnt 采样次数
+ * @param jitter 输出
+ */
+HAPI void
+sched_thread_self_test(const u64 period_ns, const usz cnt, sched_jitter_t *jitter)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        u64 next_ns = (u64)ts.tv_sec * NANO_PER_SEC + (u64)ts.tv_nsec;
+        u64 sum_ns  = 0;
+
+        jitter->cnt    = cnt;
+        jitter->max_ns = 0;
+        for (usz i = 0; i < cnt; i++) {
+                next_ns   += period_ns;
+                ts.tv_sec  = (time_t)(next_ns / NANO_PER_SEC);
+                ts.tv_nsec = (long)(next_ns % NANO_PER_SEC);
+                while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+                        ;
+
+                clock_gettime(CLOCK_MONOTONIC, &ts);
+                const u64 now_ns = (u64)ts.tv_sec * NANO_PER_SEC + (u64)ts.tv_nsec;
+                const u64 lat_ns = (now_ns > next_ns) ? now_ns - next_ns : 0;
+
+                sum_ns         += lat_ns;
+                jitter->max_ns  = MAX(jitter->max_ns, lat_ns);
+        }
+        jitter->avg_ns = cnt ? sum_ns / cnt : 0;
+}
+
+/* 在目标线程内执行, 各项设置失败只打印, 不阻止线程运行 */
+HAPI void
+sched_thread_setup(const sched_rt_cfg_t *rt, const int cpu_id)
+{
+        sched_bind_thread_to_cpu(pthread_self(), cpu_id);
+
+        if (rt->timer_slack_ns && prctl(PR_SET_TIMERSLACK, (unsigned long)rt->timer_slack_ns, 0, 0, 0) != 0)
+                printf("[SCHED]set timer slack failed, errcode: %d\n", errno);
+
+        int ret;
+        if (rt->stack_size && (ret = sched_thread_prefault_stack()) != 0)
+                printf("[SCHED]prefault stack failed, errcode: %d\n", ret);
+
+        ret = sched_thread_set_policy(rt);
+        if (ret)
+                printf("[SCHED]set realtime policy %d failed, errcode: %d\n", rt->e_policy, ret);
+
+        if (rt->self_test_cnt) {
+                sched_jitter_t jitter;
+                sched_thread_self_test(SCHED_SELF_TEST_PERIOD_NS, rt->self_test_cnt, &jitter);
+                printf("[SCHED]CPU %d self-test: %llu wakeups, jitter avg %.1f us, max %.1f us\n", cpu_id,
+                       (unsigned long long)jitter.cnt, jitter.avg_ns / 1e3, jitter.max_ns / 1e3);
+        }
+}
 #elif defined(_WIN32)
 #include <windows.h>
 
+typedef LPTHREAD_START_ROUTINE sched_thread_f;
+
 HAPI DWORD WINAPI sched_thread_exec(LPVOID arg);
 HAPI void
 sched_bind_thread_to_cpu(HANDLE thread_handle, int cpu_id)
@@ -52,38 +222,126 @@ sched_thread_exec(LPVOID arg)
 {
         struct sched *t = (struct sched *)arg;
         while (true)
-                sched_exec(t);
+                sched_poll(t);
         return 0;
 }
+
+/* Windows 只支持亲和性与 SCHED_RT_FIFO (映射为 TIME_CRITICAL 优先级) */
+HAPI void
+sched_thread_setup(const sched_rt_cfg_t *rt, const int cpu_id)
+{
+        sched_bind_thread_to_cpu(GetCurrentThread(), cpu_id);
+        if (rt->e_policy == SCHED_RT_FIFO && !SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+                printf("[SCHED]set thread priority failed, errcode: %lu\n", GetLastError());
+}
 #endif
 
+#if defined(__linux__) || defined(_WIN32)
+/* 让出 CPU, 空闲轮询时使用 */
 HAPI void
-sched_thread_init(void *arg, int cpu_id)
+sched_thread_yield(void)
 {
 #ifdef __linux__
+        sched_yield();
+#elif defined(_WIN32)
+        SwitchToThread();
+#endif
+}
+
+typedef struct {
+        sched_thread_f        f_thread;
+        void                 *arg;
+        const sched_rt_cfg_t *rt;
+        int                   cpu_id;
+        ATOMIC(bool) ready; // 新线程已取走参数
+} sched_thread_ctx_t;
+
+#ifdef __linux__
+HAPI void *
+sched_thread_entry(void *arg)
+#else
+HAPI DWORD WINAPI
+sched_thread_entry(LPVOID arg)
+#endif
+{
+        sched_thread_ctx_t  *ctx      = (sched_thread_ctx_t *)arg;
+        const sched_thread_f f_thread = ctx->f_thread;
+        void                *f_arg    = ctx->arg;
+
+        sched_thread_setup(ctx->rt, ctx->cpu_id);
+        ATOMIC_STORE_EXPLICIT(&ctx->ready, true, memory_order_release);
+        return f_thread(f_arg);
+}
+
+/**
+ * @brief 创建线程, 在线程内完成绑核与实时设置后再进入 f_thread
+ *
+ * 等待新线程完成设置 (包括抖动自测) 后返回.
+ *
+ * @param f_thread 线程函数
+ * @param arg 线程参数
+ * @param cpu_id
+ * @param rt 实时设置, NULL 表示只绑核
+ * @return 0 成功, -MECREATE 创建失败
+ */
+HAPI int
+sched_thread_create(sched_thread_f f_thread, void *arg, int cpu_id, const sched_rt_cfg_t *rt)
+{
+        static const sched_rt_cfg_t rt_none = {.e_policy = SCHED_RT_NONE};
+
+        sched_thread_ctx_t ctx = {.f_thread = f_thread, .arg = arg, .rt = rt ? rt : &rt_none, .cpu_id = cpu_id};
+        ATOMIC_STORE_EXPLICIT(&ctx.ready, false, memory_order_relaxed);
+
+#ifdef __linux__
+        if (ctx.rt->mlock && mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+                printf("[SCHED]mlockall failed, errcode: %d\n", errno);
+
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        if (ctx.rt->stack_size)
+                pthread_attr_setstacksize(&attr, ctx.rt->stack_size);
+
         pthread_t sched_tid;
-        int       ret = pthread_create(&sched_tid, NULL, sched_thread_exec, arg);
+        int       ret = pthread_create(&sched_tid, &attr, sched_thread_entry, &ctx);
+        pthread_attr_destroy(&attr);
         if (ret != 0) {
                 printf("[SCHED]create thread failed, errcode: %d\n", ret);
-                return;
+                return -MECREATE;
         }
+        pthread_detach(sched_tid);
 #elif defined(_WIN32)
         DWORD  thread_id;
-        HANDLE sched_tid = CreateThread(NULL,              // 默认安全属性
-                                        0,                 // 默认堆栈大小
-                                        sched_thread_exec, // 线程函数
-                                        arg,               // 传递给线程函数的参数
-                                        0,                 // 默认创建标志
-                                        &thread_id         // 用于接收线程ID
+        HANDLE sched_tid = CreateThread(NULL,               // 默认安全属性
+                                        ctx.rt->stack_size, // 堆栈大小, 0 为默认
+                                        sched_thread_entry, // 线程函数
+                                        &ctx,               // 传递给线程函数的参数
+                                        0,                  // 默认创建标志
+                                        &thread_id          // 用于接收线程ID
         );
         if (sched_tid == NULL) {
                 printf("[SCHED]create thread failed, errcode: %lu\n", GetLastError());
-                return;
+                return -MECREATE;
         }
+        CloseHandle(sched_tid);
+#endif
+
+        // ctx 位于本函数栈上, 等新线程取走后才能返回
+        while (!ATOMIC_LOAD_EXPLICIT(&ctx.ready, memory_order_acquire))
+                sched_thread_yield();
+        return 0;
+}
 #endif
 
+HAPI int
+sched_thread_init(void *arg, int cpu_id, const sched_rt_cfg_t *rt)
+{
 #if defined(__linux__) || defined(_WIN32)
-        sched_bind_thread_to_cpu(sched_tid, cpu_id);
+        return sched_thread_create(sched_thread_exec, arg, cpu_id, rt);
+#else
+        ARG_UNUSED(arg);
+        ARG_UNUSED(cpu_id);
+        ARG_UNUSED(rt);
+        return 0;
 #endif
 }
 
@@ -112,20 +112,89 @@ shm_init(shm_t *shm, shm_cfg_t shm_cfg)
         return 0;
 }
 
-HAPI void
+HAPI usz
 shm_read(shm_t *shm, void *dst, usz size)
 {
         DECL_PTRS(shm, lo);
 
-        spsc_read_buf(lo->spsc, (u8 *)lo->base + sizeof(*lo->spsc), dst, size);
+        return spsc_read_buf(lo->spsc, (u8 *)lo->base + sizeof(*lo->spsc), dst, size);
 }
 
-HAPI void
+HAPI usz
 shm_write(shm_t *shm, void *src, usz size)
 {
         DECL_PTRS(shm, lo);
 
-        spsc_write_buf(lo->spsc, (u8 *)lo->base + sizeof(*lo->spsc), src, size);
+        const usz ret = spsc_write_buf(lo->spsc, (u8 *)lo->base + sizeof(*lo->spsc), src, size);
+        spsc_write_wake(lo->spsc);
+        return ret;
+}
+
+HAPI isz
+shm_msg_write(shm_t *shm, const void *src, usz size)
+{
+        DECL_PTRS(shm, lo);
+
+        const isz ret = spsc_msg_write_buf(lo->spsc, (u8 *)lo->base + sizeof(*lo->spsc), src, size);
+        spsc_write_wake(lo->spsc);
+        return ret;
+}
+
+HAPI isz
+shm_msg_peek_len(shm_t *shm)
+{
+        DECL_PTRS(shm, lo);
+
+        return spsc_msg_peek_len_buf(lo->spsc, (u8 *)lo->base + sizeof(*lo->spsc));
+}
+
+HAPI isz
+shm_msg_read(shm_t *shm, void *dst, usz cap)
+{
+        DECL_PTRS(shm, lo);
+
+        return spsc_msg_read_buf(lo->spsc, (u8 *)lo->base + sizeof(*lo->spsc), dst, cap);
+}
+
+HAPI isz
+shm_wait(shm_t *shm, usz size, u64 timeout_ns)
+{
+        DECL_PTRS(shm, lo);
+
+        return spsc_wait_avail(lo->spsc, size, timeout_ns);
+}
+
+HAPI usz
+shm_write_reserve(shm_t *shm, usz size, spsc_span_t *span)
+{
+        DECL_PTRS(shm, lo);
+
+        return spsc_write_reserve_buf(lo->spsc, (u8 *)lo->base + sizeof(*lo->spsc), size, span);
+}
+
+HAPI void
+shm_write_commit(shm_t *shm, usz size)
+{
+        DECL_PTRS(shm, lo);
+
+        spsc_write_commit(lo->spsc, size);
+        spsc_write_wake(lo->spsc);
+}
+
+HAPI usz
+shm_read_peek(shm_t *shm, usz size, spsc_span_t *span)
+{
+        DECL_PTRS(shm, lo);
+
+        return spsc_read_peek_buf(lo->spsc, (u8 *)lo->base + sizeof(*lo->spsc), size, span);
+}
+
+HAPI void
+shm_read_release(shm_t *shm, usz size)
+{
+        DECL_PTRS(shm, lo);
+
+        spsc_read_release(lo->spsc, size);
 }
 
 #endif // !SHM_H
@@ -10,9 +10,10 @@ log_t g_log;
 #define WRITE_THREAD_NUM 1000
 u64 PRODUCERS_CNTS[WRITE_THREAD_NUM];
 
-u8              LOG_FLUSH_BUF[128];
-u8              LOG_BUF[1024 * 1024];
-static mpsc_p_t PRODUCERS[WRITE_THREAD_NUM];
+u8                 LOG_FLUSH_BUF[128];
+u8                 LOG_BUF[1024 * 1024];
+static mpsc_p_t    PRODUCERS[WRITE_THREAD_NUM];
+static log_shard_t SHARDS[WRITE_THREAD_NUM];
 
 HAPI void
 log_stdout(void *fp, const u8 *src, size_t size)
@@ -47,11 +48,15 @@ write_thread_func(void *arg)
 }
 
 int
-main()
+main(int argc, char **argv)
 {
+        // ./log_test shard 使用每线程分片后端
+        const bool shard = argc > 1 && strcmp(argv[1], "shard") == 0;
+
         log_cfg_t log_cfg = {
             .e_mode     = LOG_MODE_SYNC,
             .e_level    = LOG_LEVEL_DEBUG,
+            .e_backend  = shard ? LOG_BACKEND_SHARD : LOG_BACKEND_MPSC,
             .fp         = stdout,
             .buf        = (void *)LOG_BUF,
             .cap        = sizeof(LOG_BUF),
@@ -59,6 +64,8 @@ main()
             .flush_cap  = sizeof(LOG_FLUSH_BUF),
             .producers  = (mpsc_p_t *)&PRODUCERS,
             .nproducers = ARRAY_LEN(PRODUCERS),
+            .shards     = SHARDS,
+            .nshards    = ARRAY_LEN(SHARDS),
             .f_flush    = log_stdout,
             .f_get_ts   = get_mono_ts_us,
         };
@@ -0,0 +1,186 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ds/mpmc.h"
+#include "ds/mpsc.h"
+#include "util/timeops.h"
+
+#define QUEUE_CAP   (1024)
+#define ITEM_CNT    (1000000)
+#define BATCH_SIZE  (8)
+#define THREADS_MAX (8)
+
+typedef struct {
+        u64 seq; // 生产者内序号
+        u64 id;  // 生产者编号
+} item_t;
+
+typedef enum {
+        BENCH_MPMC,       // mpmc 单条
+        BENCH_MPMC_BATCH, // mpmc 批量
+        BENCH_MPSC_MUTEX, // mpsc + 消费端互斥锁
+} bench_e;
+
+static const char *BENCH_NAME[] = {"mpmc", "mpmc-batch", "mpsc+mutex"};
+
+typedef struct {
+        bench_e         e_bench;
+        usz             nproducers;
+        usz             nconsumers;
+        mpmc_t          mpmc;
+        mpsc_t          mpsc;
+        mpsc_p_t        producers[THREADS_MAX];
+        pthread_mutex_t mutex;
+        ATOMIC(u64) consumed; // 已消费条数
+        ATOMIC(u64) checksum; // 已消费 seq 之和
+} bench_t;
+
+typedef struct {
+        bench_t *bench;
+        usz      id;
+        u64      cnt;
+} worker_t;
+
+static u8 MPMC_BUF[MPMC_BUF_SIZE(QUEUE_CAP, sizeof(item_t))] CACHELINE_ALIGNED;
+static u8 MPSC_BUF[QUEUE_CAP * sizeof(item_t)];
+
+void *
+producer_thread_func(void *arg)
+{
+        worker_t *w     = (worker_t *)arg;
+        bench_t  *bench = w->bench;
+        mpsc_p_t *p     = (bench->e_bench == BENCH_MPSC_MUTEX) ? mpsc_reg(&bench->mpsc, w->id) : NULL;
+
+        item_t items[BATCH_SIZE];
+        u64    seq = 0;
+        while (seq < w->cnt) {
+                switch (bench->e_bench) {
+                        case BENCH_MPMC: {
+                                items[0] = (item_t){.seq = seq, .id = w->id};
+                                if (mpmc_push(&bench->mpmc, &items[0]))
+                                        seq++;
+                                else
+                                        sched_yield();
+                                break;
+                        }
+                        case BENCH_MPMC_BATCH: {
+                                const usz n = (usz)MIN((u64)BATCH_SIZE, w->cnt - seq);
+                                for (usz i = 0; i < n; i++)
+                                        items[i] = (item_t){.seq = seq + i, .id = w->id};
+                                const usz pushed = mpmc_push_n(&bench->mpmc, items, n);
+                                if (pushed == 0)
+                                        sched_yield();
+                                // 未写入的部分下一轮重新填充
+                                seq += pushed;
+                                break;
+                        }
+                        case BENCH_MPSC_MUTEX: {
+                                items[0] = (item_t){.seq = seq, .id = w->id};
+                                if (mpsc_write(&bench->mpsc, p, &items[0], sizeof(item_t)) >= 0)
+                                        seq++;
+                                else
+                                        sched_yield();
+                                break;
+                        }
+                }
+        }
+
+        if (p)
+                mpsc_unreg(p);
+        return NULL;
+}
+
+void *
+consumer_thread_func(void *arg)
+{
+        worker_t *w     = (worker_t *)arg;
+        bench_t  *bench = w->bench;
+        const u64 total = ITEM_CNT;
+
+        item_t items[BATCH_SIZE];
+        u64    sum = 0;
+        while (ATOMIC_LOAD_EXPLICIT(&bench->consumed, memory_order_relaxed) < total) {
+                usz n = 0;
+                switch (bench->e_bench) {
+                        case BENCH_MPMC: {
+                                n = mpmc_pop(&bench->mpmc, &items[0]) ? 1 : 0;
+                                break;
+                        }
+                        case BENCH_MPMC_BATCH: {
+                                n = mpmc_pop_n(&bench->mpmc, items, BATCH_SIZE);
+                                break;
+                        }
+                        case BENCH_MPSC_MUTEX: {
+                                pthread_mutex_lock(&bench->mutex);
+                                n = mpsc_read(&bench->mpsc, &items[0], sizeof(item_t)) ? 1 : 0;
+                                pthread_mutex_unlock(&bench->mutex);
+                                break;
+                        }
+                }
+
+                if (n == 0) {
+                        sched_yield();
+                        continue;
+                }
+                for (usz i = 0; i < n; i++)
+                        sum += items[i].seq;
+                ATOMIC_FETCH_ADD_EXPLICIT(&bench->consumed, n, memory_order_relaxed);
+        }
+
+        ATOMIC_FETCH_ADD_EXPLICIT(&bench->checksum, sum, memory_order_relaxed);
+        return NULL;
+}
+
+HAPI void
+bench_run(bench_e e_bench, usz nproducers, usz nconsumers)
+{
+        static bench_t bench;
+        bench.e_bench    = e_bench;
+        bench.nproducers = nproducers;
+        bench.nconsumers = nconsumers;
+        ATOMIC_STORE_EXPLICIT(&bench.consumed, 0, memory_order_relaxed);
+        ATOMIC_STORE_EXPLICIT(&bench.checksum, 0, memory_order_relaxed);
+        mpmc_init(&bench.mpmc, MPMC_BUF, QUEUE_CAP, sizeof(item_t));
+        mpsc_init(&bench.mpsc, MPSC_BUF, sizeof(MPSC_BUF), bench.producers, nproducers);
+        pthread_mutex_init(&bench.mutex, NULL);
+
+        pthread_t tids[THREADS_MAX * 2];
+        worker_t  workers[THREADS_MAX * 2];
+        u64       expect = 0;
+
+        const u64 begin_ns = get_mono_ts_ns();
+        for (usz i = 0; i < nproducers; i++) {
+                const u64 cnt = ITEM_CNT / nproducers + ((i < ITEM_CNT % nproducers) ? 1 : 0);
+                workers[i]    = (worker_t){.bench = &bench, .id = i, .cnt = cnt};
+                expect += cnt * (cnt - 1) / 2;
+                pthread_create(&tids[i], NULL, producer_thread_func, &workers[i]);
+        }
+        for (usz i = nproducers; i < nproducers + nconsumers; i++) {
+                workers[i] = (worker_t){.bench = &bench, .id = i};
+                pthread_create(&tids[i], NULL, consumer_thread_func, &workers[i]);
+        }
+        for (usz i = 0; i < nproducers + nconsumers; i++)
+                pthread_join(tids[i], NULL);
+        const u64 end_ns = get_mono_ts_ns();
+
+        pthread_mutex_destroy(&bench.mutex);
+
+        const u64 checksum = ATOMIC_LOAD_EXPLICIT(&bench.checksum, memory_order_relaxed);
+        printf("%-10s %lluP/%lluC: %.2f Mops/s%s\n", BENCH_NAME[e_bench], nproducers, nconsumers,
+               ITEM_CNT * 1e3 / (f64)(end_ns - begin_ns), (checksum == expect) ? "" : "  [checksum mismatch]");
+}
+
+int
+main()
+{
+        printf("sizeof(mpmc_t): %llu, cell size: %llu\n", (usz)sizeof(mpmc_t), (usz)MPMC_CELL_SIZE(sizeof(item_t)));
+
+        const usz threads[] = {1, 2, 4};
+        for (usz i = 0; i < ARRAY_LEN(threads); i++) {
+                for (int e = BENCH_MPMC; e <= BENCH_MPSC_MUTEX; e++)
+                        bench_run((bench_e)e, threads[i], threads[i]);
+        }
+        return 0;
+}
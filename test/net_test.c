@@ -1,3 +1,6 @@
+#define MP_MAGAZINE
+#define MP_INLINE_BUF
+
 #include <pthread.h>
 #include <stdio.h>
 #include <string.h>
@@ -76,7 +79,7 @@ send_recv_thread(void *arg)
 HAPI int
 init(void)
 {
-        mp_init(&mp);
+        mp_init_policy(&mp, MP_POLICY_SLAB);
 
         FILE *fp = fopen("net_log.bin", "a+");
 
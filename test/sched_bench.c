@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sched/sched.h"
+#include "util/typedef.h"
+
+#define TASKS_MAX (512)
+#define SIM_TICKS (1000000) // 模拟 1s, 单位 us
+
+static const usz TASK_FREQ[] = {100, 200, 500, 1000, 2000}; // 任务频率分布, Hz
+
+static const char *SCHED_NAME[] = {"fcfs", "rbtree", "wheel", "edf"};
+
+static sched_t       sched;
+static sched_task_t  tasks[TASKS_MAX];
+static dheap_entry_t heap_buf[TASKS_MAX];
+static u64           fake_time_us;
+static u64           dispatch_cnt;
+
+u64
+get_ts_us(void)
+{
+        return fake_time_us;
+}
+
+void
+task_cb(void *arg)
+{
+        (void)arg;
+        dispatch_cnt++;
+}
+
+HAPI void
+bench_run(sched_type_e e_type, usz task_num)
+{
+        fake_time_us = 0;
+        dispatch_cnt = 0;
+
+        const sched_cfg_t cfg = {
+            .cpu_id   = SCHED_CPU_NONE,
+            .e_type   = e_type,
+            .e_tick   = SCHED_TICK_US,
+            .f_get_ts = get_ts_us,
+            .tasks    = tasks,
+            .task_max = ARRAY_LEN(tasks),
+            .heap_buf = heap_buf,
+        };
+        sched_init(&sched, cfg);
+
+        for (usz i = 0; i < task_num; i++) {
+                const sched_task_cfg_t task_cfg = {
+                    .id         = i,
+                    .priority   = 1,
+                    .exec_freq  = TASK_FREQ[i % ARRAY_LEN(TASK_FREQ)],
+                    .delay_tick = i, // 错开初始相位
+                    .f_cb       = task_cb,
+                };
+                sched_add_task(&sched, task_cfg);
+        }
+
+        // 每个 tick 执行一轮, 一轮内执行所有到期任务
+        u64       exec_cnt = 0;
+        const u64 begin_ns = get_mono_ts_ns();
+        for (u64 tick = 1; tick <= SIM_TICKS; tick++) {
+                fake_time_us = tick;
+                sched_exec(&sched);
+                exec_cnt++;
+        }
+        const u64 end_ns = get_mono_ts_ns();
+
+        const f64 total_ns = (f64)(end_ns - begin_ns);
+        printf("%-6s %3llu tasks: %8llu dispatches, %6.1f ns/exec, %6.1f ns/dispatch\n", SCHED_NAME[e_type], (usz)task_num,
+               dispatch_cnt, total_ns / (f64)exec_cnt, total_ns / (f64)dispatch_cnt);
+}
+
+int
+main()
+{
+        const usz task_nums[] = {8, 64, 512};
+        for (usz i = 0; i < ARRAY_LEN(task_nums); i++) {
+                bench_run(SCHED_TYPE_CFS, task_nums[i]);
+                bench_run(SCHED_TYPE_WHEEL, task_nums[i]);
+                bench_run(SCHED_TYPE_EDF, task_nums[i]);
+        }
+        return 0;
+}
@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <unistd.h>
+
+#include "sched/sched.h"
+#include "util/timeops.h"
+
+#define ACT_NUM  (3)   // 热插拔的执行器数量
+#define STAGE_MS (200) // 每个阶段运行时间
+#define CMD_CAP  (16)
+
+static sched_t      sched;
+static sched_task_t tasks[ACT_NUM];
+static u8           cmd_buf[SCHED_CMD_BUF_SIZE(CMD_CAP)] CACHELINE_ALIGNED;
+static ATOMIC(u64) poll_cnt[ACT_NUM + 1];
+
+void
+poll_cb(void *arg)
+{
+        ATOMIC_FETCH_ADD_EXPLICIT(&poll_cnt[(usz)arg], 1, memory_order_relaxed);
+}
+
+HAPI void
+cmd_post(const sched_cmd_e e_cmd, const usz id, const usz exec_freq)
+{
+        const sched_cmd_t cmd = {
+            .e_cmd    = e_cmd,
+            .task_cfg = {.id = id, .exec_freq = exec_freq, .f_cb = poll_cb, .arg = (void *)id},
+        };
+        while (sched_cmd_post(&sched, cmd) < 0)
+                usleep(100);
+}
+
+/* 运行一个阶段, 打印各执行器在该阶段的轮询次数 */
+HAPI void
+stage_run(const char *name)
+{
+        u64 begin[ACT_NUM + 1];
+        for (usz i = 0; i <= ACT_NUM; i++)
+                begin[i] = ATOMIC_LOAD_EXPLICIT(&poll_cnt[i], memory_order_relaxed);
+
+        usleep(STAGE_MS * 1000);
+
+        printf("%-28s", name);
+        for (usz i = 0; i <= ACT_NUM; i++)
+                printf(" act%llu %4llu", i, ATOMIC_LOAD_EXPLICIT(&poll_cnt[i], memory_order_relaxed) - begin[i]);
+        printf("\n");
+}
+
+int
+main(void)
+{
+        const sched_cfg_t cfg = {
+            .cpu_id      = 0,
+            .e_type      = SCHED_TYPE_WHEEL,
+            .e_tick      = SCHED_TICK_US,
+            .f_get_ts    = get_mono_ts_us,
+            .tasks       = tasks,
+            .task_max    = ARRAY_LEN(tasks),
+            .e_idle      = SCHED_IDLE_SLEEP,
+            .spin_window = 50,
+            .cmd_buf     = cmd_buf,
+            .cmd_cap     = CMD_CAP,
+        };
+        sched_init(&sched, cfg);
+        sched_start(&sched);
+
+        // 调度线程已在运行, 以下操作都经命令队列在调度线程中生效
+        for (usz i = 0; i < ACT_NUM; i++)
+                cmd_post(SCHED_CMD_ADD, i, 500);
+        stage_run("add act0~2 @500Hz");
+
+        cmd_post(SCHED_CMD_RETUNE, 1, 1000);
+        stage_run("retune act1 -> 1000Hz");
+
+        cmd_post(SCHED_CMD_PAUSE, 2, 0);
+        stage_run("pause act2");
+
+        cmd_post(SCHED_CMD_RESUME, 2, 0);
+        stage_run("resume act2");
+
+        // 任务数组已满, 新执行器复用 act0 的位置
+        cmd_post(SCHED_CMD_ADD, ACT_NUM, 250);
+        cmd_post(SCHED_CMD_REMOVE, 0, 0);
+        cmd_post(SCHED_CMD_ADD, ACT_NUM, 250);
+        stage_run("remove act0, add act3 @250Hz");
+
+        sched_stats_t stats;
+        sched_stats_snapshot(&sched, &stats);
+        printf("commands %llu, failed %llu (first add of act3 rejected: task array full)\n", stats.cmd_cnt,
+               stats.cmd_fail_cnt);
+        return 0;
+}
@@ -0,0 +1,216 @@
+#define MP_MAGAZINE
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "comm/net.h"
+#include "ds/mp.h"
+#include "ds/spsc.h"
+#include "sched/coro.h"
+#include "sched/reactor.h"
+#include "util/timeops.h"
+
+#define ACT_NUM    (200)  // 并发的执行器事务, 每个一个协程
+#define TXN_NUM    (20)   // 每个执行器的事务数
+#define TXN_GAP_US (2000) // 事务间隔
+#define RECV_TO_US (5000) // 应答超时
+#define SP_NUM     (100)  // 设定值数量
+#define SP_GAP_US  (3000) // 设定值产生间隔
+#define SP_IDLE_MS (100)  // 超过该时间没有新设定值时结束
+#define ECHO_IP    "127.0.0.1"
+#define ECHO_PORT  (23401)
+
+typedef struct {
+        sched_coro_t co;
+        net_ch_t     ch;
+        usz          idx, txn;
+        u64          tx_ts;
+        char         tx[32], rx[32];
+} act_t;
+
+static mp_t            mp;
+static u8              MP_BUF[4 * MP_SIZE];
+static net_t           net;
+static sched_t         sched;
+static sched_task_t    tasks[ACT_NUM + 1];
+static sched_reactor_t rt;
+static act_t           acts[ACT_NUM];
+static sched_coro_t    sp_co;
+static spsc_t          sp_ring;
+static u8              SP_BUF[1024];
+
+static usz                  done_num, ok_cnt, timeout_cnt, sp_cnt;
+static sched_hist_counter_t rtt; // 发送到协程恢复的时间 (us)
+static ATOMIC(bool) echo_ready;
+
+/* 模拟执行器: 原样返回收到的数据 */
+void *
+echo_thread(void *arg)
+{
+        ARG_UNUSED(arg);
+
+        const sockfd_t     fd   = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        struct sockaddr_in addr = {
+            .sin_family = AF_INET,
+            .sin_port   = htons(ECHO_PORT),
+            .sin_addr =
+                {
+                    .s_addr = inet_addr(ECHO_IP),
+                },
+        };
+        bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+        ATOMIC_STORE_EXPLICIT(&echo_ready, true, memory_order_release);
+
+        char buf[64];
+        for (;;) {
+                struct sockaddr_in src;
+                socklen_t          len  = sizeof(src);
+                const isz          size = recvfrom(fd, buf, sizeof(buf), 0, (struct sockaddr *)&src, &len);
+                if (size > 0)
+                        sendto(fd, buf, size, 0, (struct sockaddr *)&src, len);
+        }
+        return NULL;
+}
+
+/* 另一线程产生设定值 */
+void *
+sp_thread(void *arg)
+{
+        ARG_UNUSED(arg);
+
+        for (u32 i = 0; i < SP_NUM; i++) {
+                while (!spsc_write(&sp_ring, &i, sizeof(i)))
+                        usleep(100);
+                usleep(SP_GAP_US);
+        }
+        return NULL;
+}
+
+void
+on_send_done(net_ch_t *ch, void *buf, int ret)
+{
+        ARG_UNUSED(ch);
+        ARG_UNUSED(buf);
+        ARG_UNUSED(ret);
+}
+
+/* 一个执行器的事务序列: 发送指令, 等待应答, 间隔后继续 */
+sched_coro_ret_e
+act_coro(sched_coro_t *co)
+{
+        act_t *act = CONTAINER_OF(co, act_t, co);
+
+        SCHED_CORO_BEGIN(co);
+        for (act->txn = 0; act->txn < TXN_NUM; act->txn++) {
+                act->tx_ts = get_mono_ts_us();
+                net_async_send(&net, &act->ch, act->tx,
+                               (usz)snprintf(act->tx, sizeof(act->tx), "ACT_%llu_%llu", act->idx, act->txn));
+                net_async_recv(&net, &act->ch, act->rx, sizeof(act->rx), RECV_TO_US);
+
+                // 接收自带超时, 协程不再另设超时
+                SCHED_CORO_AWAIT(co, SCHED_WAKE_NEVER);
+                if (co->lo.res > 0) {
+                        ok_cnt++;
+                        sched_hist_record(&rtt, get_mono_ts_us() - act->tx_ts);
+                } else {
+                        timeout_cnt++;
+                }
+
+                SCHED_CORO_SLEEP(co, TXN_GAP_US);
+        }
+        done_num++;
+        SCHED_CORO_END(co);
+}
+
+/* 等待设定值到达, 一段时间没有新设定值后结束 */
+sched_coro_ret_e
+sp_coro(sched_coro_t *co)
+{
+        SCHED_CORO_BEGIN(co);
+        for (;;) {
+                SCHED_CORO_AWAIT_SPSC(co, &sp_ring, MS2US(SP_IDLE_MS));
+                if (co->lo.timeout)
+                        break;
+
+                u32 sp;
+                while (spsc_read(&sp_ring, &sp, sizeof(sp)) == sizeof(sp))
+                        sp_cnt++;
+        }
+        done_num++;
+        SCHED_CORO_END(co);
+}
+
+int
+main(void)
+{
+        mp_init_ext(&mp, MP_BUF, sizeof(MP_BUF));
+        mp_set_policy(&mp, MP_POLICY_SLAB);
+        spsc_init(&sp_ring, SP_BUF, sizeof(SP_BUF), SPSC_POLICY_REJECT);
+
+        pthread_t echo_tid, sp_tid;
+        pthread_create(&echo_tid, NULL, echo_thread, NULL);
+        while (!ATOMIC_LOAD_EXPLICIT(&echo_ready, memory_order_acquire))
+                delay_ms(1, YIELD);
+
+        const net_cfg_t net_cfg = {.e_type = NET_TYPE_UDP, .mp = &mp, .ring_len = 1024};
+        if (net_init(&net, net_cfg) < 0) {
+                printf("io_uring init failed\n");
+                return -1;
+        }
+
+        const sched_cfg_t cfg = {
+            .cpu_id      = SCHED_CPU_NONE,
+            .e_type      = SCHED_TYPE_WHEEL,
+            .e_tick      = SCHED_TICK_US,
+            .f_get_ts    = get_mono_ts_us,
+            .tasks       = tasks,
+            .task_max    = ARRAY_LEN(tasks),
+            .spin_window = 20,
+        };
+        sched_init(&sched, cfg);
+
+        // 每个执行器一个通道, 应答回调唤醒对应的协程
+        for (usz i = 0; i < ACT_NUM; i++) {
+                act_t *act = &acts[i];
+                act->idx   = i;
+                act->ch    = (net_ch_t){
+                       .dst_ip    = ECHO_IP,
+                       .dst_port  = ECHO_PORT,
+                       .e_mode    = NET_MODE_ASYNC,
+                       .f_send_cb = on_send_done,
+                       .f_recv_cb = sched_coro_net_cb,
+                       .arg       = &act->co,
+                };
+                if (net_add_ch(&net, &act->ch) < 0)
+                        return -1;
+
+                const sched_coro_cfg_t co_cfg = {.id = i, .exec_freq = 1000, .f_cb = act_coro};
+                sched_coro_spawn(&sched, &act->co, co_cfg);
+        }
+        const sched_coro_cfg_t sp_cfg = {.id = ACT_NUM, .exec_freq = 1000, .f_cb = sp_coro};
+        sched_coro_spawn(&sched, &sp_co, sp_cfg);
+
+        const sched_reactor_cfg_t rt_cfg = {.sched = &sched, .net = &net};
+        sched_reactor_init(&rt, rt_cfg);
+
+        // 所有协程在一个线程中运行, 不阻塞
+        pthread_create(&sp_tid, NULL, sp_thread, NULL);
+        const u64 begin_us = get_mono_ts_us();
+        while (done_num < ACT_NUM + 1)
+                sched_reactor_poll(&rt);
+        const u64 end_us = get_mono_ts_us();
+        pthread_join(sp_tid, NULL);
+
+        sched_hist_t hist;
+        sched_hist_snapshot(&rtt, &hist);
+        printf("%d actuators x %d transactions in %llu ms: ok %llu, timeout %llu\n", ACT_NUM, TXN_NUM,
+               (end_us - begin_us) / 1000, ok_cnt, timeout_cnt);
+        printf("rtt us: avg %.1f, p50 %llu, p99 %llu, max %llu\n", hist.num ? (f64)hist.sum / (f64)hist.num : 0.0,
+               sched_hist_quantile(&hist, 0.5), sched_hist_quantile(&hist, 0.99), hist.max);
+        printf("setpoints %llu / %d\n", sp_cnt, SP_NUM);
+
+        net_destroy(&net);
+        return 0;
+}
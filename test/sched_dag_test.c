@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <unistd.h>
+
+#include "sched/dag.h"
+#include "util/timeops.h"
+
+#define WORKER_NUM (4)
+#define JOB_CAP    (256)
+#define RUN_MS     (500)
+
+/* 控制周期: 读取响应 -> 状态估计 -> 4 条腿的控制器并行 -> 指令编码 -> 发送 */
+enum {
+        STAGE_READ,
+        STAGE_EST,
+        STAGE_LIMB0,
+        STAGE_LIMB1,
+        STAGE_LIMB2,
+        STAGE_LIMB3,
+        STAGE_ENCODE,
+        STAGE_SEND,
+        STAGE_NUM,
+};
+
+#define LIMBS (BIT(STAGE_LIMB0) | BIT(STAGE_LIMB1) | BIT(STAGE_LIMB2) | BIT(STAGE_LIMB3))
+
+static sched_group_t  group;
+static sched_worker_t workers[WORKER_NUM];
+static usz            job_buf[WORKER_NUM * JOB_CAP];
+static u8             inject_buf[MPMC_BUF_SIZE(JOB_CAP, sizeof(sched_job_t *))] CACHELINE_ALIGNED;
+static sched_task_t   tasks[WORKER_NUM][2];
+
+static sched_dag_t dag;
+static u64         stage_us[STAGE_NUM] = {20, 50, 100, 100, 100, 100, 20, 10}; // 各阶段的模拟计算量
+
+void
+stage_cb(void *arg)
+{
+        const u64 us       = *(const u64 *)arg;
+        const u64 begin_ns = get_mono_ts_ns();
+        while (get_mono_ts_ns() - begin_ns < us * 1000)
+                ;
+}
+
+static sched_dag_node_t nodes[STAGE_NUM] = {
+    [STAGE_READ]   = {.name = "read", .f_cb = stage_cb, .arg = &stage_us[STAGE_READ]},
+    [STAGE_EST]    = {.name = "estimate", .f_cb = stage_cb, .arg = &stage_us[STAGE_EST], .deps = BIT(STAGE_READ)},
+    [STAGE_LIMB0]  = {.name = "limb0", .f_cb = stage_cb, .arg = &stage_us[STAGE_LIMB0], .deps = BIT(STAGE_EST)},
+    [STAGE_LIMB1]  = {.name = "limb1", .f_cb = stage_cb, .arg = &stage_us[STAGE_LIMB1], .deps = BIT(STAGE_EST)},
+    [STAGE_LIMB2]  = {.name = "limb2", .f_cb = stage_cb, .arg = &stage_us[STAGE_LIMB2], .deps = BIT(STAGE_EST)},
+    [STAGE_LIMB3]  = {.name = "limb3", .f_cb = stage_cb, .arg = &stage_us[STAGE_LIMB3], .deps = BIT(STAGE_EST)},
+    [STAGE_ENCODE] = {.name = "encode", .f_cb = stage_cb, .arg = &stage_us[STAGE_ENCODE], .deps = LIMBS},
+    [STAGE_SEND]   = {.name = "send", .f_cb = stage_cb, .arg = &stage_us[STAGE_SEND], .deps = BIT(STAGE_ENCODE)},
+};
+
+HAPI void
+dag_report(const char *name)
+{
+        sched_hist_t span;
+        sched_hist_snapshot(&dag.lo.span, &span);
+        printf("[%s] %llu cycles, span p50 %llu us, p99 %llu us\n", name, span.num,
+               sched_hist_quantile(&span, 0.5) / 1000, sched_hist_quantile(&span, 0.99) / 1000);
+
+        for (usz i = 0; i < STAGE_NUM; i++) {
+                sched_dag_stage_stats_t stats;
+                sched_dag_stage_snapshot(&dag, i, &stats);
+                printf("    %-8s last [%6.1f, %6.1f] us, exec p50 %6.1f us\n", nodes[i].name, stats.begin_ns / 1e3,
+                       stats.end_ns / 1e3, sched_hist_quantile(&stats.exec, 0.5) / 1e3);
+        }
+
+        usz       path[STAGE_NUM];
+        const usz len = sched_dag_critical_path(&dag, path, ARRAY_LEN(path));
+        printf("    critical path:");
+        for (usz i = 0; i < len; i++)
+                printf(" %s", nodes[path[i]].name);
+        printf("\n");
+}
+
+int
+main(void)
+{
+        const long cpu_num = sysconf(_SC_NPROCESSORS_ONLN);
+
+        // 串行: DAG 直接在调用线程中执行
+        sched_dag_init(&dag, (sched_dag_cfg_t){.nodes = nodes, .node_num = STAGE_NUM});
+        for (usz i = 0; i < 100; i++)
+                sched_dag_exec(&dag);
+        dag_report("serial");
+
+        // 并行: DAG 作为 0 号工作者上的 1 kHz 周期任务, 各条腿的控制器由其它工作者窃取执行
+        sched_cfg_t sched_cfgs[WORKER_NUM];
+        for (usz i = 0; i < WORKER_NUM; i++) {
+                sched_cfgs[i] = (sched_cfg_t){
+                    .cpu_id   = (u8)(i % (usz)cpu_num),
+                    .e_type   = SCHED_TYPE_WHEEL,
+                    .e_tick   = SCHED_TICK_US,
+                    .f_get_ts = get_mono_ts_us,
+                    .tasks    = tasks[i],
+                    .task_max = ARRAY_LEN(tasks[i]),
+                };
+        }
+
+        const sched_group_cfg_t group_cfg = {
+            .workers    = workers,
+            .worker_num = WORKER_NUM,
+            .job_buf    = job_buf,
+            .job_cap    = JOB_CAP,
+            .inject_buf = inject_buf,
+        };
+        int ret = sched_group_init(&group, group_cfg, sched_cfgs);
+        if (ret < 0) {
+                printf("sched group init failed, errcode: %d\n", ret);
+                return -1;
+        }
+
+        sched_dag_init(&dag, (sched_dag_cfg_t){.nodes = nodes, .node_num = STAGE_NUM, .group = &group});
+        const sched_task_cfg_t dag_cfg = {.id = 0, .exec_freq = 1000, .f_cb = sched_dag_exec, .arg = &dag};
+        sched_group_add_task(&group, 0, dag_cfg);
+
+        sched_group_start(&group);
+        usleep(RUN_MS * 1000);
+        sched_group_stop(&group);
+
+        dag_report("group");
+        return 0;
+}
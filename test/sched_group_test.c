@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "sched/group.h"
+#include "util/timeops.h"
+
+#define WORKER_NUM (4)
+#define JOB_CAP    (1024)
+#define JOB_NUM    (512) // 一次性任务数, 每个再派生一个子任务
+#define SPIN_NS    (20000)
+#define IDLE_MS    (200) // 任务完成后空闲一段时间, 统计工作者的 CPU 占用
+
+static sched_group_t  group;
+static sched_worker_t workers[WORKER_NUM];
+static usz            job_buf[WORKER_NUM * JOB_CAP];
+static u8             inject_buf[MPMC_BUF_SIZE(JOB_CAP, sizeof(sched_job_t *))] CACHELINE_ALIGNED;
+static sched_task_t   tasks[WORKER_NUM][4];
+
+static sched_job_t jobs[JOB_NUM];
+static sched_job_t child_jobs[JOB_NUM];
+static ATOMIC(u64) done_cnt;
+static u64 tick_cnt;
+
+HAPI void
+spin_ns(const u64 ns)
+{
+        const u64 begin_ns = get_mono_ts_ns();
+        while (get_mono_ts_ns() - begin_ns < ns)
+                ;
+}
+
+void
+child_job_cb(void *arg)
+{
+        (void)arg;
+        spin_ns(SPIN_NS);
+        ATOMIC_FETCH_ADD_EXPLICIT(&done_cnt, 1, memory_order_relaxed);
+}
+
+void
+job_cb(void *arg)
+{
+        // 在工作者线程内派生子任务, 压入本地队列, 可被空闲工作者窃取
+        sched_job_t *child = (sched_job_t *)arg;
+        sched_group_submit(&group, child);
+        spin_ns(SPIN_NS);
+        ATOMIC_FETCH_ADD_EXPLICIT(&done_cnt, 1, memory_order_relaxed);
+}
+
+void
+tick_cb(void *arg)
+{
+        (void)arg;
+        tick_cnt++;
+}
+
+int
+main(void)
+{
+        const long cpu_num = sysconf(_SC_NPROCESSORS_ONLN);
+
+        sched_cfg_t sched_cfgs[WORKER_NUM];
+        for (usz i = 0; i < WORKER_NUM; i++) {
+                sched_cfgs[i] = (sched_cfg_t){
+                    .cpu_id      = (u8)(i % (usz)cpu_num),
+                    .e_type      = SCHED_TYPE_WHEEL,
+                    .e_tick      = SCHED_TICK_US,
+                    .f_get_ts    = get_mono_ts_us,
+                    .tasks       = tasks[i],
+                    .task_max    = ARRAY_LEN(tasks[i]),
+                    .e_idle      = SCHED_IDLE_SLEEP,
+                    .spin_window = 50,
+                };
+        }
+
+        const sched_group_cfg_t group_cfg = {
+            .workers    = workers,
+            .worker_num = WORKER_NUM,
+            .job_buf    = job_buf,
+            .job_cap    = JOB_CAP,
+            .inject_buf = inject_buf,
+        };
+        int ret = sched_group_init(&group, group_cfg, sched_cfgs);
+        if (ret < 0) {
+                printf("sched group init failed, errcode: %d\n", ret);
+                return -1;
+        }
+
+        // 周期任务固定在 0 号工作者
+        const sched_task_cfg_t tick_cfg = {.id = 0, .exec_freq = 1000, .f_cb = tick_cb};
+        sched_group_add_task(&group, 0, tick_cfg);
+
+        sched_group_start(&group);
+
+        // 所有任务从同一个线程提交, 由各工作者分担
+        const u64 begin_ns = get_mono_ts_ns();
+        for (usz i = 0; i < JOB_NUM; i++) {
+                child_jobs[i] = (sched_job_t){.f_cb = child_job_cb};
+                jobs[i]       = (sched_job_t){.f_cb = job_cb, .arg = &child_jobs[i]};
+                while (sched_group_submit(&group, &jobs[i]) < 0)
+                        sched_thread_yield();
+        }
+        while (ATOMIC_LOAD_EXPLICIT(&done_cnt, memory_order_relaxed) < JOB_NUM * 2)
+                sched_thread_yield();
+        const u64 end_ns = get_mono_ts_ns();
+
+        // 空闲期间工作者休眠, 只有 0 号工作者在周期任务前后短暂自旋
+        struct rusage ru_begin, ru_end;
+        getrusage(RUSAGE_SELF, &ru_begin);
+        usleep(IDLE_MS * 1000);
+        getrusage(RUSAGE_SELF, &ru_end);
+        const f64 cpu_ms = (f64)(ru_end.ru_utime.tv_sec - ru_begin.ru_utime.tv_sec) * 1e3 +
+                           (f64)(ru_end.ru_utime.tv_usec - ru_begin.ru_utime.tv_usec) / 1e3 +
+                           (f64)(ru_end.ru_stime.tv_sec - ru_begin.ru_stime.tv_sec) * 1e3 +
+                           (f64)(ru_end.ru_stime.tv_usec - ru_begin.ru_stime.tv_usec) / 1e3;
+
+        sched_group_stop(&group);
+
+        printf("%d jobs done in %.2f ms, periodic ticks on worker 0: %llu\n", JOB_NUM * 2, (end_ns - begin_ns) / 1e6,
+               tick_cnt);
+        for (usz i = 0; i < WORKER_NUM; i++) {
+                printf("worker %llu (cpu %u): jobs %llu, stolen %llu, sleeps %llu\n", i, workers[i].cpu_id,
+                       ATOMIC_LOAD_EXPLICIT(&workers[i].job_cnt, memory_order_relaxed),
+                       ATOMIC_LOAD_EXPLICIT(&workers[i].steal_cnt, memory_order_relaxed),
+                       workers[i].sched.lo.idle.sleep_cnt);
+        }
+        printf("cpu time while idle for %d ms: %.1f ms\n", IDLE_MS, cpu_ms);
+        return 0;
+}
@@ -0,0 +1,92 @@
+#include <stdio.h>
+
+#include "sched/sched.h"
+#include "util/timeops.h"
+
+#define RUN_US (1000000) // 每种策略运行 1s
+
+typedef struct {
+        const char  *name;
+        sched_idle_e e_idle;
+        usz          spin_window; // us
+} idle_case_t;
+
+static const idle_case_t IDLE_CASES[] = {
+    {.name = "spin", .e_idle = SCHED_IDLE_SPIN},
+    {.name = "sleep", .e_idle = SCHED_IDLE_SLEEP, .spin_window = 0},
+    {.name = "sleep+spin50", .e_idle = SCHED_IDLE_SLEEP, .spin_window = 50},
+};
+
+static sched_t      sched;
+static sched_task_t tasks[4];
+static u64          jitter_sum;
+static u64          jitter_max;
+static u64          release_cnt;
+
+/* 回调开始时刻与释放时刻之差 */
+void
+task_cb(void *arg)
+{
+        const sched_task_t *task   = (const sched_task_t *)arg;
+        const u64           now    = get_mono_ts_us();
+        const u64           jitter = now - task->status.next_exec_ts;
+
+        jitter_sum += jitter;
+        jitter_max  = MAX(jitter_max, jitter);
+        release_cnt++;
+}
+
+HAPI u64
+cpu_time_ns(void)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return (u64)ts.tv_sec * NANO_PER_SEC + (u64)ts.tv_nsec;
+}
+
+HAPI void
+idle_run(const idle_case_t *idle_case)
+{
+        jitter_sum  = 0;
+        jitter_max  = 0;
+        release_cnt = 0;
+
+        const sched_cfg_t cfg = {
+            .cpu_id      = SCHED_CPU_NONE,
+            .e_type      = SCHED_TYPE_WHEEL,
+            .e_tick      = SCHED_TICK_US,
+            .f_get_ts    = get_mono_ts_us,
+            .tasks       = tasks,
+            .task_max    = ARRAY_LEN(tasks),
+            .e_idle      = idle_case->e_idle,
+            .spin_window = idle_case->spin_window,
+        };
+        sched_init(&sched, cfg);
+
+        const usz freqs[] = {1000, 200};
+        for (usz i = 0; i < ARRAY_LEN(freqs); i++) {
+                const sched_task_cfg_t task_cfg = {.id = i, .exec_freq = freqs[i], .f_cb = task_cb, .arg = &tasks[i]};
+                sched_add_task(&sched, task_cfg);
+        }
+
+        const u64 cpu_begin_ns = cpu_time_ns();
+        const u64 end_us       = get_mono_ts_us() + RUN_US;
+        while (get_mono_ts_us() < end_us)
+                sched_poll(&sched);
+        const u64 cpu_ns = cpu_time_ns() - cpu_begin_ns;
+
+        const sched_idle_stat_t *idle = &sched.lo.idle;
+        printf("%-12s cpu %5.1f%%, release jitter avg %6.1f us max %5llu us, wakeup latency avg %6.1f us max %6.1f us, "
+               "late %llu/%llu\n",
+               idle_case->name, cpu_ns / (RUN_US * 10.0), (f64)jitter_sum / (f64)MAX(release_cnt, 1ULL), jitter_max,
+               idle->sleep_cnt ? (f64)idle->wake_lat_ns_sum / (f64)idle->sleep_cnt / 1e3 : 0.0,
+               (f64)idle->wake_lat_ns_max / 1e3, idle->late_cnt, idle->sleep_cnt);
+}
+
+int
+main(void)
+{
+        for (usz i = 0; i < ARRAY_LEN(IDLE_CASES); i++)
+                idle_run(&IDLE_CASES[i]);
+        return 0;
+}
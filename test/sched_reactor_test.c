@@ -0,0 +1,176 @@
+#define MP_MAGAZINE
+#define MP_INLINE_BUF
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "comm/net.h"
+#include "ds/mp.h"
+#include "sched/reactor.h"
+#include "util/timeops.h"
+
+#define RUN_MS     (1000)
+#define ECHO_IP    "127.0.0.1"
+#define ECHO_PORT  (23400)
+#define CTRL_HZ    (500)  // 控制任务: 发送指令并等待执行器应答
+#define MON_HZ     (1000) // 监控任务: 与网络无关的周期任务
+#define RECV_TO_US (1000) // 应答超时
+
+static mp_t            mp;
+static net_t           net;
+static sched_t         sched;
+static sched_task_t    tasks[2];
+static sched_reactor_t rt;
+
+static char tx_buf[64], rx_buf[64];
+static u64  tx_ts, rx_cnt, timeout_cnt, mon_cnt;
+
+static sched_hist_counter_t rtt; // 发送到应答回调执行的时间 (us)
+static ATOMIC(bool) echo_ready;
+
+/* 模拟执行器: 原样返回收到的数据 */
+void *
+echo_thread(void *arg)
+{
+        ARG_UNUSED(arg);
+
+        const sockfd_t     fd   = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        struct sockaddr_in addr = {
+            .sin_family = AF_INET,
+            .sin_port   = htons(ECHO_PORT),
+            .sin_addr =
+                {
+                    .s_addr = inet_addr(ECHO_IP),
+                },
+        };
+        bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+        ATOMIC_STORE_EXPLICIT(&echo_ready, true, memory_order_release);
+
+        char buf[64];
+        for (;;) {
+                struct sockaddr_in src;
+                socklen_t          len  = sizeof(src);
+                const isz          size = recvfrom(fd, buf, sizeof(buf), 0, (struct sockaddr *)&src, &len);
+                if (size > 0)
+                        sendto(fd, buf, size, 0, (struct sockaddr *)&src, len);
+        }
+        return NULL;
+}
+
+void
+on_send_done(net_ch_t *ch, void *buf, int ret)
+{
+        ARG_UNUSED(ch);
+        ARG_UNUSED(buf);
+        ARG_UNUSED(ret);
+}
+
+/* 在反应器线程执行, 与任务回调之间无需同步 */
+void
+on_recv_done(net_ch_t *ch, void *buf, int ret)
+{
+        ARG_UNUSED(ch);
+        ARG_UNUSED(buf);
+
+        if (ret < 0) {
+                timeout_cnt++;
+                return;
+        }
+        rx_cnt++;
+        sched_hist_record(&rtt, get_mono_ts_us() - tx_ts);
+}
+
+void
+ctrl_cb(void *arg)
+{
+        net_ch_t *ch = (net_ch_t *)arg;
+
+        const usz size = (usz)snprintf(tx_buf, sizeof(tx_buf), "CNT_%llu", tasks[0].status.exec_cnt);
+        tx_ts          = get_mono_ts_us();
+        net_async_send(&net, ch, tx_buf, size);
+        net_async_recv(&net, ch, rx_buf, sizeof(rx_buf), RECV_TO_US);
+}
+
+void
+mon_cb(void *arg)
+{
+        ARG_UNUSED(arg);
+        mon_cnt++;
+}
+
+void *
+stop_thread(void *arg)
+{
+        ARG_UNUSED(arg);
+        delay_ms(RUN_MS, YIELD);
+        sched_reactor_stop(&rt);
+        return NULL;
+}
+
+int
+main(void)
+{
+        mp_init_policy(&mp, MP_POLICY_SLAB);
+
+        pthread_t echo_tid, stop_tid;
+        pthread_create(&echo_tid, NULL, echo_thread, NULL);
+        while (!ATOMIC_LOAD_EXPLICIT(&echo_ready, memory_order_acquire))
+                delay_ms(1, YIELD);
+
+        const net_cfg_t net_cfg = {.e_type = NET_TYPE_UDP, .mp = &mp, .ring_len = 64};
+        if (net_init(&net, net_cfg) < 0) {
+                printf("io_uring init failed\n");
+                return -1;
+        }
+
+        net_ch_t ch = {
+            .dst_ip    = ECHO_IP,
+            .dst_port  = ECHO_PORT,
+            .e_mode    = NET_MODE_ASYNC,
+            .f_send_cb = on_send_done,
+            .f_recv_cb = on_recv_done,
+        };
+        if (net_add_ch(&net, &ch) < 0)
+                return -1;
+
+        // 调度器不创建线程, 由反应器在主线程驱动
+        const sched_cfg_t cfg = {
+            .cpu_id      = SCHED_CPU_NONE,
+            .e_type      = SCHED_TYPE_WHEEL,
+            .e_tick      = SCHED_TICK_US,
+            .f_get_ts    = get_mono_ts_us,
+            .tasks       = tasks,
+            .task_max    = ARRAY_LEN(tasks),
+            .spin_window = 20,
+        };
+        sched_init(&sched, cfg);
+
+        const sched_task_cfg_t ctrl_cfg = {.id = 0, .exec_freq = CTRL_HZ, .f_cb = ctrl_cb, .arg = &ch};
+        const sched_task_cfg_t mon_cfg  = {.id = 1, .exec_freq = MON_HZ, .f_cb = mon_cb};
+        sched_add_task(&sched, ctrl_cfg);
+        sched_add_task(&sched, mon_cfg);
+
+        const sched_reactor_cfg_t rt_cfg = {.sched = &sched, .net = &net};
+        sched_reactor_init(&rt, rt_cfg);
+
+        pthread_create(&stop_tid, NULL, stop_thread, NULL);
+        sched_reactor_run(&rt);
+        pthread_join(stop_tid, NULL);
+
+        sched_hist_t hist;
+        sched_hist_snapshot(&rtt, &hist);
+        printf("ctrl %llu (rx %llu, timeout %llu), mon %llu\n", tasks[0].status.exec_cnt, rx_cnt, timeout_cnt, mon_cnt);
+        printf("rtt us: avg %.1f, p50 %llu, p99 %llu, max %llu\n", hist.num ? (f64)hist.sum / (f64)hist.num : 0.0,
+               sched_hist_quantile(&hist, 0.5), sched_hist_quantile(&hist, 0.99), hist.max);
+
+        const sched_reactor_stat_t *stat = &rt.lo.stat;
+        const sched_idle_stat_t    *idle = &sched.lo.idle;
+        printf("reactor: wait %llu, timer %llu, rearm %llu, net cqe %llu\n", stat->wait_cnt, stat->timer_cnt,
+               stat->rearm_cnt, stat->net_cnt);
+        printf("timer wake latency: avg %llu ns, max %llu ns, late %llu\n",
+               idle->sleep_cnt ? idle->wake_lat_ns_sum / idle->sleep_cnt : 0, idle->wake_lat_ns_max, idle->late_cnt);
+
+        net_destroy(&net);
+        return 0;
+}
@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <unistd.h>
+
+#include "sched/sched.h"
+#include "util/timeops.h"
+
+#define RUN_MS (1000)
+
+static sched_t      sched;
+static sched_task_t tasks[4];
+static u64          jitter_max;
+
+void
+task_cb(void *arg)
+{
+        const sched_task_t *task   = (const sched_task_t *)arg;
+        const u64           jitter = get_mono_ts_us() - task->status.next_exec_ts;
+
+        // 任务在 sched_start 前添加, 首次释放要等线程完成抖动自测, 不计入
+        if (task->status.exec_cnt)
+                jitter_max = MAX(jitter_max, jitter);
+}
+
+int
+main(void)
+{
+        // 非 root 或非 PREEMPT_RT 内核上实时策略设置会失败并打印错误, 其余设置仍然生效
+        const sched_cfg_t cfg = {
+            .cpu_id      = 0,
+            .e_type      = SCHED_TYPE_WHEEL,
+            .e_tick      = SCHED_TICK_US,
+            .f_get_ts    = get_mono_ts_us,
+            .tasks       = tasks,
+            .task_max    = ARRAY_LEN(tasks),
+            .e_idle      = SCHED_IDLE_SLEEP,
+            .spin_window = 50,
+            .rt =
+                {
+                    .e_policy       = SCHED_RT_FIFO,
+                    .fifo_prio      = 80,
+                    .mlock          = true,
+                    .stack_size     = 256 * 1024,
+                    .timer_slack_ns = 1,
+                    .self_test_cnt  = 1000,
+                },
+        };
+
+        sched_init(&sched, cfg);
+
+        const sched_task_cfg_t task_cfg = {.id = 0, .exec_freq = 1000, .f_cb = task_cb, .arg = &tasks[0]};
+        sched_add_task(&sched, task_cfg);
+
+        // sched_start 在线程完成实时设置与抖动自测后返回
+        sched_start(&sched);
+
+        usleep(RUN_MS * 1000);
+        printf("task executed %llu times in %d ms, release jitter max %llu us\n", (usz)tasks[0].status.exec_cnt, RUN_MS,
+               jitter_max);
+        return 0;
+}
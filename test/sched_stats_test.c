@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <unistd.h>
+
+#include "sched/sched.h"
+#include "sched/stats_shm.h"
+#include "shm/shm.h"
+#include "util/timeops.h"
+
+#define RUN_MS     (1000)
+#define REPORT_MS  (250)
+#define SHM_NAME   "sched_stats"
+#define SPIN_US    (300)  // 慢任务的常规执行时间
+#define SPIN_US_OV (6000) // 每 50 次执行一次超过周期
+
+static sched_t      sched;
+static sched_task_t tasks[4];
+
+HAPI void
+spin_us(const u64 us)
+{
+        const u64 begin_us = get_mono_ts_us();
+        while (get_mono_ts_us() - begin_us < us)
+                ;
+}
+
+void
+fast_cb(void *arg)
+{
+        (void)arg;
+}
+
+void
+slow_cb(void *arg)
+{
+        const sched_task_t *task = (const sched_task_t *)arg;
+        spin_us((task->status.exec_cnt % 50 == 49) ? SPIN_US_OV : SPIN_US);
+}
+
+HAPI void
+hist_print(const char *name, const sched_hist_t *hist)
+{
+        printf("    %-6s n %6llu, avg %7.1f, p50 %5llu, p99 %5llu, p99.9 %5llu, max %5llu\n", name, hist->num,
+               hist->num ? (f64)hist->sum / (f64)hist->num : 0.0, sched_hist_quantile(hist, 0.5),
+               sched_hist_quantile(hist, 0.99), sched_hist_quantile(hist, 0.999), hist->max);
+}
+
+HAPI void
+stats_print(const sched_stats_t *stats, usz task_idx, const sched_task_stats_t *task)
+{
+        if (task_idx == 0)
+                printf("sched cpu %u: util %5.1f%%, dispatch %llu\n", stats->cpu_id, stats->util * 100,
+                       stats->dispatch_cnt);
+        printf("  task %llu: exec %llu, overrun %llu, miss %llu (tick = us)\n", task->id, task->exec_cnt,
+               task->overrun_cnt, task->miss_cnt);
+        hist_print("jitter", &task->jitter);
+        hist_print("exec", &task->exec);
+}
+
+int
+main(void)
+{
+        const sched_cfg_t cfg = {
+            .cpu_id      = 0,
+            .e_type      = SCHED_TYPE_WHEEL,
+            .e_tick      = SCHED_TICK_US,
+            .f_get_ts    = get_mono_ts_us,
+            .tasks       = tasks,
+            .task_max    = ARRAY_LEN(tasks),
+            .e_idle      = SCHED_IDLE_SLEEP,
+            .spin_window = 50,
+        };
+        sched_init(&sched, cfg);
+
+        const sched_task_cfg_t fast_cfg = {.id = 0, .exec_freq = 1000, .f_cb = fast_cb, .arg = &tasks[0]};
+        const sched_task_cfg_t slow_cfg = {.id = 1, .exec_freq = 200, .f_cb = slow_cb, .arg = &tasks[1]};
+        sched_add_task(&sched, fast_cfg);
+        sched_add_task(&sched, slow_cfg);
+        sched_start(&sched);
+
+        // 调度线程运行期间无锁读取快照
+        sched_stats_t stats;
+        for (usz ms = REPORT_MS; ms <= RUN_MS; ms += REPORT_MS) {
+                usleep(REPORT_MS * 1000);
+                sched_stats_snapshot(&sched, &stats);
+                printf("[%4llu ms] util %5.1f%%, dispatch %llu\n", ms, stats.util * 100, stats.dispatch_cnt);
+        }
+
+        // 镜像到 shm, 外部监控进程以相同方式读取
+        shm_t           shm     = {0};
+        const shm_cfg_t shm_cfg = {.name = SHM_NAME, .access = SHM_READWRITE, .cap = 64 * 1024};
+        if (shm_init(&shm, shm_cfg) < 0) {
+                printf("shm init failed\n");
+                return -1;
+        }
+
+        const usz         msg_num = sched_stats_publish(&sched, &shm);
+        sched_stats_msg_t msg;
+        for (usz i = 0; i < msg_num; i++) {
+                if (shm_msg_read(&shm, &msg, sizeof(msg)) != sizeof(msg))
+                        break;
+                stats_print(&msg.sched, msg.task_idx, &msg.task);
+        }
+
+        shm_unlink(SHM_NAME);
+        return 0;
+}
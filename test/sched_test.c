@@ -2,33 +2,220 @@
 #include <stdio.h>
 
 #include "sched/sched.h"
+#include "util/timeops.h"
 #include "util/typedef.h"
 
-sched_t cfs;
+#define SIM_HOURS (1) // 长时间仿真的虚拟时长
 
-u64 fake_time_us = 0;
+sched_t      cfs;
+sched_task_t cfs_tasks[8];
 
-u64
-get_ts_us(void)
-{
-        return fake_time_us;
-}
+typedef struct {
+        const char *name;
+        u64         cost_us; // 每次执行消耗的虚拟时间
+        sched_t    *sched;
+} load_t;
 
 void
 task_cb(void *arg)
 {
         const char *name = (const char *)arg;
-        printf("[%.6llu] Task %s executed\n", fake_time_us, name);
+        printf("[%.6llu] Task %s executed\n", sched_now(&cfs), name);
+}
+
+void
+load_cb(void *arg)
+{
+        const load_t *load = (const load_t *)arg;
+        sched_consume(load->sched, load->cost_us);
+}
+
+void
+count_cb(void *arg)
+{
+        (*(u64 *)arg)++;
+}
+
+/* 控制环与慢速后台任务在同一 tick 释放, 对比 CFS 与 EDF 下控制环的截止期错过次数 */
+void
+edf_demo(sched_type_e e_type, const char *name)
+{
+        static sched_t       sched;
+        static sched_task_t  tasks[4];
+        static dheap_entry_t heap_buf[4];
+        static load_t        ctrl  = {.name = "ctrl", .cost_us = 50, .sched = &sched};
+        static load_t        house = {.name = "house", .cost_us = 150, .sched = &sched};
+
+        const sched_cfg_t sched_cfg = {
+            .e_type   = e_type,
+            .e_tick   = SCHED_TICK_US,
+            .tasks    = tasks,
+            .task_max = ARRAY_LEN(tasks),
+            .heap_buf = heap_buf,
+            .virt     = true,
+        };
+        sched_init(&sched, sched_cfg);
+
+        const sched_task_cfg_t task_cfgs[] = {
+            {.id = 0, .priority = 1, .exec_freq = 1000, .deadline = 250, .wcet = 60, .f_cb = load_cb, .arg = &ctrl},
+            {.id = 1, .priority = 0, .exec_freq = 100, .wcet = 160, .f_cb = load_cb, .arg = &house},
+            {.id = 2, .priority = 0, .exec_freq = 100, .wcet = 160, .f_cb = load_cb, .arg = &house},
+            // 超出利用率上限, EDF 下被拒绝
+            {.id = 3, .priority = 0, .exec_freq = 100, .wcet = 9000, .f_cb = load_cb, .arg = &house},
+        };
+        for (usz i = 0; i < ARRAY_LEN(task_cfgs); i++) {
+                const int ret = sched_add_task(&sched, task_cfgs[i]);
+                if (ret < 0)
+                        printf("[%s] task %llu rejected, errcode: %d\n", name, (usz)i, ret);
+        }
+
+        sched_run_until(&sched, 100000);
+
+        for (usz i = 0; i < sched.lo.task_num; i++) {
+                const sched_task_t *task = &tasks[i];
+                printf("[%s] task %llu (%s): exec %llu, miss %llu\n", name, (usz)i, ((load_t *)task->cfg.arg)->name,
+                       (usz)task->status.exec_cnt, (usz)task->status.miss_cnt);
+        }
+}
+
+typedef struct {
+        sched_t *sched;
+        u64      off_grid; // 开始时刻不在 1 ms 边界上的次数
+} cmd_stream_t;
+
+/* 1 kHz 指令流, 平时耗时 50 us, 每 100 次有一次耗时 3.5 ms */
+void
+cmd_stream_cb(void *arg)
+{
+        cmd_stream_t       *stream = (cmd_stream_t *)arg;
+        const sched_task_t *task   = &stream->sched->cfg.tasks[0];
+        if (sched_now(stream->sched) % 1000)
+                stream->off_grid++;
+        sched_consume(stream->sched, (task->status.exec_cnt % 100 == 99) ? 3500 : 50);
+}
+
+/* 对比三种错过释放的处理方式, 运行 1 s 虚拟时间 */
+void
+overrun_demo(sched_overrun_e e_overrun, const char *name)
+{
+        static sched_t      sched;
+        static sched_task_t tasks[1];
+        static cmd_stream_t stream;
+
+        const sched_cfg_t sched_cfg = {
+            .e_type   = SCHED_TYPE_WHEEL,
+            .e_tick   = SCHED_TICK_US,
+            .tasks    = tasks,
+            .task_max = ARRAY_LEN(tasks),
+            .virt     = true,
+        };
+        sched_init(&sched, sched_cfg);
+        stream = (cmd_stream_t){.sched = &sched};
+
+        const sched_task_cfg_t task_cfg = {
+            .id        = 0,
+            .exec_freq = 1000,
+            .e_overrun = e_overrun,
+            .burst_max = 2,
+            .f_cb      = cmd_stream_cb,
+            .arg       = &stream,
+        };
+        sched_add_task(&sched, task_cfg);
+        sched_run_until(&sched, 1000000 - 1);
+
+        sched_task_stats_t stats;
+        sched_task_stats_snapshot(&tasks[0], &stats);
+        printf("[%-7s] exec %llu, skipped %llu, off 1 ms grid %llu\n", name, stats.exec_cnt, stats.skip_cnt,
+               stream.off_grid);
+}
+
+/* 首次执行后无超时休眠, 休眠期间修改频率, 唤醒后应按新频率回到原相位 */
+void
+sleep_cb(void *arg)
+{
+        cmd_stream_t *stream = (cmd_stream_t *)arg;
+        sched_task_t *task   = &stream->sched->cfg.tasks[0];
+        if (task->status.exec_cnt == 0)
+                sched_task_sleep(stream->sched, task, SCHED_WAKE_NEVER);
+        else if (sched_now(stream->sched) > 12000 && sched_now(stream->sched) % 2000)
+                stream->off_grid++;
+}
+
+void
+retune_demo(void)
+{
+        static sched_t      sched;
+        static sched_task_t tasks[1];
+        static cmd_stream_t stream;
+
+        const sched_cfg_t sched_cfg = {
+            .e_type   = SCHED_TYPE_WHEEL,
+            .e_tick   = SCHED_TICK_US,
+            .tasks    = tasks,
+            .task_max = ARRAY_LEN(tasks),
+            .virt     = true,
+        };
+        sched_init(&sched, sched_cfg);
+        stream = (cmd_stream_t){.sched = &sched};
+
+        const sched_task_cfg_t task_cfg = {
+            .id        = 0,
+            .exec_freq = 1000,
+            .e_overrun = SCHED_OVERRUN_CATCHUP,
+            .f_cb      = sleep_cb,
+            .arg       = &stream,
+        };
+        sched_add_task(&sched, task_cfg);
+        sched_run_until(&sched, 10500);
+        sched_retune_task(&sched, 0, 500);
+        sched_task_wake(&sched, &tasks[0]);
+        sched_run_until(&sched, 100000 - 1);
+
+        // 唤醒时补执行休眠期间错过的 5 次释放, 之后每 2 ms 一次
+        printf("[retune ] exec %llu, phase %llu, off 2 ms grid %llu\n", (usz)tasks[0].status.exec_cnt,
+               (usz)tasks[0].status.phase_ts, stream.off_grid);
+}
+
+/* 虚拟时间下运行数小时的控制周期, 统计实际耗时 */
+void
+sim_demo(void)
+{
+        static sched_t      sched;
+        static sched_task_t tasks[4];
+        static u64          cnts[3];
+
+        const sched_cfg_t sched_cfg = {
+            .e_type   = SCHED_TYPE_WHEEL,
+            .e_tick   = SCHED_TICK_US,
+            .tasks    = tasks,
+            .task_max = ARRAY_LEN(tasks),
+            .virt     = true,
+        };
+        sched_init(&sched, sched_cfg);
+
+        const usz freqs[] = {1000, 100, 10};
+        for (usz i = 0; i < ARRAY_LEN(freqs); i++) {
+                const sched_task_cfg_t task_cfg = {.id = i, .exec_freq = freqs[i], .f_cb = count_cb, .arg = &cnts[i]};
+                sched_add_task(&sched, task_cfg);
+        }
+
+        const u64 begin_us = get_mono_ts_us();
+        sched_run_until(&sched, (u64)SIM_HOURS * 3600 * 1000000);
+        const u64 end_us = get_mono_ts_us();
+
+        printf("[sim] %d h simulated in %.3f s: 1 kHz %llu, 100 Hz %llu, 10 Hz %llu executions\n", SIM_HOURS,
+               (end_us - begin_us) / 1e6, cnts[0], cnts[1], cnts[2]);
 }
 
 int
 main(void)
 {
         sched_cfg_t cfg_cfg = {
-            .cpu_id   = 19,
             .e_type   = SCHED_TYPE_CFS,
             .e_tick   = SCHED_TICK_US,
-            .f_get_ts = get_ts_us,
+            .tasks    = cfs_tasks,
+            .task_max = ARRAY_LEN(cfs_tasks),
+            .virt     = true,
         };
         sched_init(&cfs, cfg_cfg);
 
@@ -66,11 +253,18 @@ main(void)
                 sched_add_task(&cfs, tasks[i]);
 
         for (int step = 0; step < 10; step++) {
-                fake_time_us += 500; // 每次增加 0.15 ms
-
                 printf("\n=== CFS step %d ===\n", step);
-                sched_exec(&cfs);
+                sched_run_until(&cfs, (u64)(step + 1) * 500); // 每步推进 0.5 ms
         }
 
+        printf("\n");
+        edf_demo(SCHED_TYPE_CFS, "cfs");
+        edf_demo(SCHED_TYPE_EDF, "edf");
+        overrun_demo(SCHED_OVERRUN_SKIP, "skip");
+        overrun_demo(SCHED_OVERRUN_CATCHUP, "catchup");
+        overrun_demo(SCHED_OVERRUN_REPHASE, "rephase");
+        retune_demo();
+        sim_demo();
+
         return 0;
 }
@@ -22,6 +22,9 @@ main()
 
         u64 cnt = 0;
         while (true) {
+                if (shm_wait(&shm, sizeof(cnt), SPSC_WAIT_FOREVER) < 0)
+                        continue;
+
                 shm_read(&shm, &cnt, sizeof(cnt));
                 printf("read cnt: %llu, spsc wp: %llu, spsc rp: %llu, spsc free: %llu\n",
                        cnt,
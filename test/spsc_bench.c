@@ -0,0 +1,191 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "shm/shm.h"
+
+#ifdef SPSC_CACHELINE_ISOLATE
+#define LAYOUT    "isolate"
+#define SHM_PING  "spsc_bench_ping_isolate"
+#define SHM_PONG  "spsc_bench_pong_isolate"
+#define SHM_THRPT "spsc_bench_thrpt_isolate"
+#else
+#define LAYOUT    "shared"
+#define SHM_PING  "spsc_bench_ping_shared"
+#define SHM_PONG  "spsc_bench_pong_shared"
+#define SHM_THRPT "spsc_bench_thrpt_shared"
+#endif
+
+#define SHM_CAP      (64 * 1024)
+#define PING_CNT     (200000)
+#define THRPT_CNT    (20000000)
+#define PRODUCER_CPU (0)
+#define CONSUMER_CPU (1)
+#define OW_CAP       (16) // 覆盖策略检查: 容量与单次写入不对齐, 每次写入都覆盖一部分未读数据
+#define OW_SIZE      (12)
+#define OW_CNT       (64)
+
+typedef struct {
+        shm_t tx;
+        shm_t rx;
+        u64   cnt;
+} bench_end_t;
+
+HAPI void
+bench_shm_open(shm_t *shm, const char *name)
+{
+        const shm_cfg_t shm_cfg = {
+            .name   = name,
+            .access = SHM_READWRITE,
+            .cap    = SHM_CAP,
+        };
+
+        const int ret = shm_init(shm, shm_cfg);
+        if (ret < 0) {
+                printf("bench: shm init failed, errcode: %d\n", ret);
+                exit(-1);
+        }
+}
+
+HAPI void
+bench_bind_cpu(int cpu_id)
+{
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(cpu_id, &cpuset);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+}
+
+void *
+pong_thread_func(void *arg)
+{
+        bench_end_t *end = (bench_end_t *)arg;
+
+        bench_bind_cpu(CONSUMER_CPU);
+
+        u64 val;
+        for (u64 i = 0; i < end->cnt; i++) {
+                while (shm_read(&end->rx, &val, sizeof(val)) == 0)
+                        ;
+                while (shm_write(&end->tx, &val, sizeof(val)) == 0)
+                        ;
+        }
+        return NULL;
+}
+
+void *
+consumer_thread_func(void *arg)
+{
+        bench_end_t *end = (bench_end_t *)arg;
+
+        bench_bind_cpu(CONSUMER_CPU);
+
+        u64 val, expect = 0;
+        while (expect < end->cnt) {
+                if (shm_read(&end->rx, &val, sizeof(val)) == 0)
+                        continue;
+                if (val != expect)
+                        printf("bench: sequence broken, expect %llu got %llu\n", expect, val);
+                expect++;
+        }
+        return NULL;
+}
+
+HAPI void
+bench_ping_pong(void)
+{
+        shm_unlink(SHM_PING);
+        shm_unlink(SHM_PONG);
+
+        // ping: 主线程 -> 对端, pong: 对端 -> 主线程, 两个进程视角的映射地址不同
+        bench_end_t ping = {.cnt = PING_CNT}, pong = {.cnt = PING_CNT};
+        bench_shm_open(&ping.tx, SHM_PING);
+        bench_shm_open(&ping.rx, SHM_PONG);
+        bench_shm_open(&pong.rx, SHM_PING);
+        bench_shm_open(&pong.tx, SHM_PONG);
+
+        pthread_t tid;
+        pthread_create(&tid, NULL, pong_thread_func, &pong);
+        bench_bind_cpu(PRODUCER_CPU);
+
+        const u64 begin_ns = get_mono_ts_ns();
+        for (u64 i = 0; i < PING_CNT; i++) {
+                u64 val = i;
+                while (shm_write(&ping.tx, &val, sizeof(val)) == 0)
+                        ;
+                while (shm_read(&ping.rx, &val, sizeof(val)) == 0)
+                        ;
+        }
+        const u64 end_ns = get_mono_ts_ns();
+
+        pthread_join(tid, NULL);
+        printf("[%s] ping-pong: %d round trips, %.1f ns/rtt\n", LAYOUT, PING_CNT, (f64)(end_ns - begin_ns) / PING_CNT);
+
+        shm_unlink(SHM_PING);
+        shm_unlink(SHM_PONG);
+}
+
+HAPI void
+bench_throughput(void)
+{
+        shm_unlink(SHM_THRPT);
+
+        bench_end_t prod = {.cnt = THRPT_CNT}, cons = {.cnt = THRPT_CNT};
+        bench_shm_open(&prod.tx, SHM_THRPT);
+        bench_shm_open(&cons.rx, SHM_THRPT);
+
+        pthread_t tid;
+        pthread_create(&tid, NULL, consumer_thread_func, &cons);
+        bench_bind_cpu(PRODUCER_CPU);
+
+        const u64 begin_ns = get_mono_ts_ns();
+        for (u64 i = 0; i < THRPT_CNT; i++) {
+                while (shm_write(&prod.tx, &i, sizeof(i)) == 0)
+                        ;
+        }
+        pthread_join(tid, NULL);
+        const u64 end_ns = get_mono_ts_ns();
+
+        printf("[%s] throughput: %d u64, %.2f Mops/s\n", LAYOUT, THRPT_CNT, THRPT_CNT * 1e3 / (f64)(end_ns - begin_ns));
+
+        shm_unlink(SHM_THRPT);
+}
+
+/* 覆盖策略: 可读数据不超过容量, 读到的总是最近写入的数据 */
+HAPI void
+bench_overwrite(void)
+{
+        spsc_t spsc;
+        u8     buf[OW_CAP];
+        spsc_init(&spsc, buf, sizeof(buf), SPSC_POLICY_OVERWRITE);
+
+        u8 src[OW_SIZE], dst[OW_CAP];
+        for (u8 i = 0; i < OW_CNT; i++) {
+                memset(src, i, sizeof(src));
+                spsc_write(&spsc, src, sizeof(src));
+                if (spsc_avail(&spsc) > OW_CAP) {
+                        printf("[%s] overwrite: FAIL, avail %llu > cap %d after write %u\n", LAYOUT,
+                               (u64)spsc_avail(&spsc), OW_CAP, i);
+                        return;
+                }
+        }
+
+        const usz size = spsc_read(&spsc, dst, sizeof(dst));
+        if (size < OW_SIZE || dst[size - 1] != OW_CNT - 1) {
+                printf("[%s] overwrite: FAIL, read %llu bytes, last %u\n", LAYOUT, (u64)size, size ? dst[size - 1] : 0);
+                return;
+        }
+        printf("[%s] overwrite: OK, %d writes of %d bytes into %d-byte ring\n", LAYOUT, OW_CNT, OW_SIZE, OW_CAP);
+}
+
+int
+main()
+{
+        printf("[%s] sizeof(spsc_t): %zu\n", LAYOUT, sizeof(spsc_t));
+
+        bench_overwrite();
+        bench_ping_pong();
+        bench_throughput();
+        return 0;
+}
@@ -61,9 +61,9 @@ typedef struct {
 } fft_out_t;
 
 typedef struct {
-        u32    elapsed_us;
-        spsc_t spsc;
-        bool   neet_exec;
+        u32        elapsed_us;
+        spsc_f32_t ring;
+        bool       neet_exec;
 #if defined(__linux__) || defined(_WIN32)
         fftwf_plan     p;
         fftwf_complex *buf;
@@ -87,7 +87,7 @@ fft_init(fft_t *fft, fft_cfg_t fft_cfg)
 
         *cfg = fft_cfg;
 
-        spsc_init(&lo->spsc, cfg->buf, cfg->points_num * sizeof(f32), SPSC_POLICY_REJECT);
+        spsc_f32_init(&lo->ring, cfg->buf, cfg->points_num);
 
         in->buf      = cfg->in_buf;
         lo->buf      = cfg->out_buf;
@@ -112,7 +112,7 @@ fft_exec(fft_t *fft)
 
         const u64 begin_ts = get_mono_ts_us();
 
-        memcpy(in->buf, lo->spsc.buf, lo->spsc.cap);
+        spsc_f32_pop_n(&lo->ring, in->buf, cfg->points_num);
 
 #if defined(__linux__) || defined(_WIN32)
         fftwf_execute(lo->p);
@@ -148,7 +148,7 @@ fft_exec_in(fft_t *fft, f32 val)
 {
         DECL_PTRS(fft, lo);
 
-        if (spsc_write(&lo->spsc, &val, sizeof(val)) == 0)
+        if (!spsc_f32_push(&lo->ring, val))
                 lo->neet_exec = true;
 }
 
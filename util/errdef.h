@@ -9,6 +9,7 @@ enum errdef_e {
         METIMEOUT,
         MECREATE,
         MEALLOC,
+        MEAGAIN,
 };
 
 #endif // !ERRDEF_H
@@ -7,6 +7,26 @@
 #define AT(addr) __attribute__((section(addr)))
 #define OPTNONE  __attribute__((optnone))
 
+#ifndef CACHELINE_SIZE
+#define CACHELINE_SIZE (64)
+#endif
+#define CACHELINE_ALIGNED __attribute__((aligned(CACHELINE_SIZE)))
+
+/* 自旋等待提示, 降低功耗并让出超线程资源 */
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define CPU_RELAX() __asm__ volatile("yield" ::: "memory")
+#else
+#define CPU_RELAX() __asm__ volatile("" ::: "memory")
+#endif
+
+#ifdef __cplusplus
+#define THREAD_LOCAL thread_local
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
 #define ATOMIC_EXEC(code)                               \
         do {                                            \
                 volatile u32 primask = __get_PRIMASK(); \
@@ -74,10 +94,14 @@
 #define ATOMIC_CAS_WEAK_EXPLICIT(a, o, n, s, f)   std::atomic_compare_exchange_weak_explicit(a, o, n, s, f)
 #define ATOMIC_CAS_STRONG_EXPLICIT(a, o, n, s, f) std::atomic_compare_exchange_strong_explicit(a, o, n, s, f)
 #define ATOMIC_EXCHANGE(a, v)                     std::atomic_exchange(a, v)
+#define ATOMIC_FETCH_ADD_EXPLICIT(a, v, m)        std::atomic_fetch_add_explicit(a, v, m)
+#define ATOMIC_FETCH_SUB_EXPLICIT(a, v, m)        std::atomic_fetch_sub_explicit(a, v, m)
+#define ATOMIC_THREAD_FENCE(m)                    std::atomic_thread_fence(m)
 constexpr auto memory_order_relaxed = std::memory_order_relaxed;
 constexpr auto memory_order_acquire = std::memory_order_acquire;
 constexpr auto memory_order_release = std::memory_order_release;
 constexpr auto memory_order_acq_rel = std::memory_order_acq_rel;
+constexpr auto memory_order_seq_cst = std::memory_order_seq_cst;
 #else
 #include <stdatomic.h>
 #define ATOMIC(type)                              _Atomic type
@@ -88,6 +112,9 @@ constexpr auto memory_order_acq_rel = std::memory_order_acq_rel;
 #define ATOMIC_CAS_WEAK_EXPLICIT(a, o, n, s, f)   atomic_compare_exchange_weak_explicit(a, o, n, s, f)
 #define ATOMIC_CAS_STRONG_EXPLICIT(a, o, n, s, f) atomic_compare_exchange_strong_explicit(a, o, n, s, f)
 #define ATOMIC_EXCHANGE(a, v)                     atomic_exchange(a, v)
+#define ATOMIC_FETCH_ADD_EXPLICIT(a, v, m)        atomic_fetch_add_explicit(a, v, m)
+#define ATOMIC_FETCH_SUB_EXPLICIT(a, v, m)        atomic_fetch_sub_explicit(a, v, m)
+#define ATOMIC_THREAD_FENCE(m)                    atomic_thread_fence(m)
 #endif
 
 #define SPINLOCK_BACKOFF_MIN (4)